@@ -12,6 +12,8 @@
 //===----------------------------------------------------------------------===//
 
 #include "ARMSelectionDAGISel.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/Transforms/Utils/PromoteMemToReg.h"
 
 using namespace llvm;
 
@@ -96,6 +98,7 @@ void ARMSelectionDAGISel::emitDAG() {
 
 void ARMSelectionDAGISel::initEntryBasicBlock() {
   BasicBlock *bb = &RF->getEntryBlock();
+  FuncInfo->computeFlagLiveness();
   for (unsigned i = 0; i < 4; i++) {
     Align MALG(32);
     AllocaInst *Alloc = new AllocaInst(Type::getInt1Ty(RF->getContext()), 0,
@@ -146,6 +149,7 @@ bool ARMSelectionDAGISel::doSelection() {
     if (FBB.getTerminator() == nullptr)
       BranchInst::Create(LBB, &FBB);
 
+  promoteFlags();
   FuncInfo->clear();
 
   LLVM_DEBUG(dbgs() << "ARMSelectionDAGISel end.\n");
@@ -153,6 +157,23 @@ bool ARMSelectionDAGISel::doSelection() {
   return true;
 }
 
+/// Rewrite the NZCV flag allocas into SSA values, inserting PHI nodes where
+/// flags are live across BasicBlocks.
+void ARMSelectionDAGISel::promoteFlags() {
+  std::vector<AllocaInst *> Allocas;
+  for (auto &Pair : FuncInfo->AllocaMap) {
+    AllocaInst *Alloc = dyn_cast<AllocaInst>(Pair.second);
+    if (Alloc != nullptr && isAllocaPromotable(Alloc))
+      Allocas.push_back(Alloc);
+  }
+
+  if (Allocas.empty())
+    return;
+
+  DominatorTree DT(*RF);
+  PromoteMemToReg(Allocas, DT);
+}
+
 bool ARMSelectionDAGISel::setjtList(std::vector<JumpTableInfo> &List) {
   jtList = List;
   return true;
@@ -40,6 +40,7 @@ private:
   void selectBasicBlock();
   void doInstructionSelection();
   void emitDAG();
+  void promoteFlags();
 
   std::unique_ptr<OptimizationRemarkEmitter> ORE;
 
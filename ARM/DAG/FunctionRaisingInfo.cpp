@@ -12,6 +12,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "FunctionRaisingInfo.h"
+#include "ARMSubtarget.h"
 #include "llvm/CodeGen/SelectionDAG.h"
 
 using namespace llvm;
@@ -56,9 +57,63 @@ void FunctionRaisingInfo::clear() {
   ArgValMap.clear();
   NodeRegMap.clear();
   AllocaMap.clear();
+  FlagValMap.clear();
   RetValMap.clear();
 }
 
+/// Get the mask of NZCV flags tested by the condition code Cond.
+static unsigned getCondFlagsMask(unsigned Cond) {
+  const unsigned N = 1 << 0, Z = 1 << 1, C = 1 << 2, V = 1 << 3;
+  switch (Cond) {
+  case ARMCC::EQ:
+  case ARMCC::NE:
+    return Z;
+  case ARMCC::HS:
+  case ARMCC::LO:
+    return C;
+  case ARMCC::MI:
+  case ARMCC::PL:
+    return N;
+  case ARMCC::VS:
+  case ARMCC::VC:
+    return V;
+  case ARMCC::HI:
+  case ARMCC::LS:
+    return C | Z;
+  case ARMCC::GE:
+  case ARMCC::LT:
+    return N | V;
+  case ARMCC::GT:
+  case ARMCC::LE:
+    return N | Z | V;
+  default:
+    return 0;
+  }
+}
+
+/// Compute the NZCV flags read by the MachineFunction. Flags are not
+/// preserved across calls, so a function-wide union of the flags tested by
+/// condition codes and read by carry-in instructions is sufficient.
+void FunctionRaisingInfo::computeFlagLiveness() {
+  LiveFlags = 0;
+  for (MachineBasicBlock &MBB : *MF) {
+    for (MachineInstr &MI : MBB) {
+      if (MI.getOpcode() == ARM::MRS) {
+        // The whole APSR is read.
+        LiveFlags = 0xF;
+        return;
+      }
+      // ADC, SBC, RSC and RRX read the carry flag.
+      if (MI.getDesc().hasImplicitUseOfPhysReg(ARM::CPSR))
+        LiveFlags |= 1 << 2;
+
+      int PIdx = MI.findFirstPredOperandIdx();
+      if (PIdx != -1 && MI.getOperand(PIdx).isImm())
+        LiveFlags |= getCondFlagsMask(MI.getOperand(PIdx).getImm());
+    }
+  }
+}
+
 /// Get the corresponding BasicBlock of given MachineBasicBlock.
 BasicBlock *FunctionRaisingInfo::getBasicBlock(MachineBasicBlock &mbb) {
   for (auto bb : MBBMap) {
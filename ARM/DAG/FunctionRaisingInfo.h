@@ -38,6 +38,12 @@ public:
   DenseMap<SDNode *, unsigned> NodeRegMap;
   /// NZCV mapping.
   DenseMap<unsigned, Value *> AllocaMap;
+  /// Mask of the NZCV flags (bit 0 is N, bit 3 is V) read by some
+  /// instruction of the function. Updates of other flags are not emitted.
+  unsigned LiveFlags;
+  /// The latest value of each NZCV flag in a BasicBlock. This keeps the flags
+  /// as SSA values within a block; AllocaMap carries them across blocks.
+  DenseMap<std::pair<BasicBlock *, unsigned>, Value *> FlagValMap;
   /// Function return IR value mapping with its parent BasicBlock, it is used
   /// to create exit BasicBlock.
   DenseMap<BasicBlock *, Value *> RetValMap;
@@ -56,6 +62,11 @@ public:
   /// FunctionRasisingInfo to an empty state, ready to be used for a
   /// different function.
   void clear();
+  /// Compute LiveFlags from the condition codes and flag reads of the
+  /// MachineFunction.
+  void computeFlagLiveness();
+  /// Check whether the given NZCV flag is read anywhere in the function.
+  bool isFlagLive(unsigned Flag) { return (LiveFlags >> Flag) & 1; }
   /// Get current raised llvm::Function.
   Function *getCRF() { return const_cast<Function *>(Fn); }
   /// Get the corresponding BasicBlock of given
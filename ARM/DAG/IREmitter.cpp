@@ -127,102 +127,147 @@ Value *IREmitter::getIRValue(SDValue val) {
 static const std::vector<StringRef> CPSR({"N_Flag", "Z_Flag", "C_Flag",
                                           "V_Flag"});
 
-// Match condition state, make corresponding processing.
-void IREmitter::emitCondCode(unsigned CondValue, BasicBlock *BB,
-                             BasicBlock *IfBB, BasicBlock *ElseBB) {
+// Get the value of the flag from the current block if it was defined or read
+// there, otherwise reload it from its alloca.
+Value *IREmitter::loadFlag(unsigned Flag) {
+  assert(FuncInfo->isFlagLive(Flag) && "Reading a flag assumed to be dead!");
+  auto Key = std::make_pair(IRB.GetInsertBlock(), Flag);
+  auto Iter = FuncInfo->FlagValMap.find(Key);
+  if (Iter != FuncInfo->FlagValMap.end())
+    return Iter->second;
+
+  Value *Val = IRB.CreateLoad(FuncInfo->AllocaMap[Flag]);
+  FuncInfo->FlagValMap[Key] = Val;
+  return Val;
+}
+
+// Record the new value of the flag. Updates of flags that are never read are
+// dropped.
+void IREmitter::storeFlag(unsigned Flag, Value *Val) {
+  if (!FuncInfo->isFlagLive(Flag))
+    return;
+
+  Val = IRB.CreateZExtOrTrunc(Val, IRB.getInt1Ty());
+  IRB.CreateStore(Val, FuncInfo->AllocaMap[Flag]);
+  FuncInfo->FlagValMap[std::make_pair(IRB.GetInsertBlock(), Flag)] = Val;
+}
+
+// Match condition state and return the i1 value that holds the result of
+// evaluating the condition CondValue, or nullptr if CondValue is not handled.
+Value *IREmitter::emitCondValue(unsigned CondValue) {
+  Value *CondPass = nullptr;
   switch (CondValue) {
   default:
     break;
   case ARMCC::EQ: { // EQ  Z set
-    Value *Z_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[1]);
-    Value *InstEQ = IRB.CreateICmpEQ(Z_Flag, IRB.getTrue());
-    IRB.CreateCondBr(InstEQ, IfBB, ElseBB);
+    Value *Z_Flag = loadFlag(1);
+    CondPass = IRB.CreateICmpEQ(Z_Flag, IRB.getTrue());
   } break;
   case ARMCC::NE: { // NE Z clear
-    Value *Z_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[1]);
-    Value *InstEQ = IRB.CreateICmpEQ(Z_Flag, IRB.getFalse());
-    IRB.CreateCondBr(InstEQ, IfBB, ElseBB);
+    Value *Z_Flag = loadFlag(1);
+    CondPass = IRB.CreateICmpEQ(Z_Flag, IRB.getFalse());
   } break;
   case ARMCC::HS: { // CS  C set
-    Value *C_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[2]);
-    Value *InstEQ = IRB.CreateICmpEQ(C_Flag, IRB.getTrue());
-    IRB.CreateCondBr(InstEQ, IfBB, ElseBB);
+    Value *C_Flag = loadFlag(2);
+    CondPass = IRB.CreateICmpEQ(C_Flag, IRB.getTrue());
   } break;
   case ARMCC::LO: { // CC  C clear
-    Value *C_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[2]);
-    Value *InstEQ = IRB.CreateICmpEQ(C_Flag, IRB.getFalse());
-    IRB.CreateCondBr(InstEQ, IfBB, ElseBB);
+    Value *C_Flag = loadFlag(2);
+    CondPass = IRB.CreateICmpEQ(C_Flag, IRB.getFalse());
   } break;
   case ARMCC::MI: { // MI  N set
-    Value *N_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[0]);
-    Value *InstEQ = IRB.CreateICmpEQ(N_Flag, IRB.getTrue());
-    IRB.CreateCondBr(InstEQ, IfBB, ElseBB);
+    Value *N_Flag = loadFlag(0);
+    CondPass = IRB.CreateICmpEQ(N_Flag, IRB.getTrue());
   } break;
   case ARMCC::PL: { // PL  N clear
-    Value *N_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[0]);
-    Value *InstEQ = IRB.CreateICmpEQ(N_Flag, IRB.getFalse());
-    IRB.CreateCondBr(InstEQ, IfBB, ElseBB);
+    Value *N_Flag = loadFlag(0);
+    CondPass = IRB.CreateICmpEQ(N_Flag, IRB.getFalse());
   } break;
   case ARMCC::VS: { // VS  V set
-    Value *V_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[3]);
-    Value *InstEQ = IRB.CreateICmpEQ(V_Flag, IRB.getTrue());
-    IRB.CreateCondBr(InstEQ, IfBB, ElseBB);
+    Value *V_Flag = loadFlag(3);
+    CondPass = IRB.CreateICmpEQ(V_Flag, IRB.getTrue());
   } break;
   case ARMCC::VC: { // VC  V clear
-    Value *V_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[3]);
-    Value *InstEQ = IRB.CreateICmpEQ(V_Flag, IRB.getFalse());
-    IRB.CreateCondBr(InstEQ, IfBB, ElseBB);
+    Value *V_Flag = loadFlag(3);
+    CondPass = IRB.CreateICmpEQ(V_Flag, IRB.getFalse());
   } break;
   case ARMCC::HI: { // HI  C set & Z clear
-    Value *C_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[2]);
-    Value *Z_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[1]);
+    Value *C_Flag = loadFlag(2);
+    Value *Z_Flag = loadFlag(1);
     Value *InstCEQ = IRB.CreateICmpEQ(C_Flag, IRB.getTrue());
     Value *InstZEQ = IRB.CreateICmpEQ(Z_Flag, IRB.getFalse());
-    Value *CondPass = IRB.CreateICmpEQ(InstCEQ, InstZEQ);
-    IRB.CreateCondBr(CondPass, IfBB, ElseBB);
+    CondPass = IRB.CreateICmpEQ(InstCEQ, InstZEQ);
   } break;
   case ARMCC::LS: { // LS  C clear or Z set
-    Value *C_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[2]);
-    Value *Z_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[1]);
+    Value *C_Flag = loadFlag(2);
+    Value *Z_Flag = loadFlag(1);
     Value *InstCEQ = IRB.CreateICmpEQ(C_Flag, IRB.getFalse());
     Value *InstZEQ = IRB.CreateICmpEQ(Z_Flag, IRB.getTrue());
-    Value *CondPass = IRB.CreateXor(InstCEQ, InstZEQ);
-    IRB.CreateCondBr(CondPass, IfBB, ElseBB);
+    CondPass = IRB.CreateXor(InstCEQ, InstZEQ);
   } break;
   case ARMCC::GE: { // GE  N = V
-    Value *N_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[0]);
-    Value *V_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[3]);
-    Value *InstEQ = IRB.CreateICmpEQ(N_Flag, V_Flag);
-    IRB.CreateCondBr(InstEQ, IfBB, ElseBB);
+    Value *N_Flag = loadFlag(0);
+    Value *V_Flag = loadFlag(3);
+    CondPass = IRB.CreateICmpEQ(N_Flag, V_Flag);
   } break;
   case ARMCC::LT: { // LT  N != V
-    Value *N_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[0]);
-    Value *V_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[3]);
-    Value *InstNE = IRB.CreateICmpNE(N_Flag, V_Flag);
-    IRB.CreateCondBr(InstNE, IfBB, ElseBB);
+    Value *N_Flag = loadFlag(0);
+    Value *V_Flag = loadFlag(3);
+    CondPass = IRB.CreateICmpNE(N_Flag, V_Flag);
   } break;
   case ARMCC::GT: { // GT  Z clear & N = V
-    Value *N_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[0]);
-    Value *Z_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[1]);
-    Value *V_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[3]);
+    Value *N_Flag = loadFlag(0);
+    Value *Z_Flag = loadFlag(1);
+    Value *V_Flag = loadFlag(3);
     Value *InstZEQ = IRB.CreateICmpEQ(Z_Flag, IRB.getFalse());
     Value *InstNZEQ = IRB.CreateICmpEQ(N_Flag, V_Flag);
-    Value *CondPass = IRB.CreateICmpEQ(InstZEQ, InstNZEQ);
-    IRB.CreateCondBr(CondPass, IfBB, ElseBB);
+    CondPass = IRB.CreateICmpEQ(InstZEQ, InstNZEQ);
   } break;
   case ARMCC::LE: { // LE  Z set or N != V
-    Value *N_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[0]);
-    Value *Z_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[1]);
-    Value *V_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[3]);
+    Value *N_Flag = loadFlag(0);
+    Value *Z_Flag = loadFlag(1);
+    Value *V_Flag = loadFlag(3);
     Value *InstZEQ = IRB.CreateICmpEQ(Z_Flag, IRB.getTrue());
     Value *InstNZNE = IRB.CreateICmpNE(N_Flag, V_Flag);
-    Value *CondPass = IRB.CreateXor(InstZEQ, InstNZNE);
-    IRB.CreateCondBr(CondPass, IfBB, ElseBB);
+    CondPass = IRB.CreateXor(InstZEQ, InstNZNE);
   } break;
   case ARMCC::AL: { // AL
     assert(false && "Emit conditional code [ARMCC::AL]. Should not get here!");
   } break;
   }
+  return CondPass;
+}
+
+// Match condition state, make corresponding processing.
+void IREmitter::emitCondCode(unsigned CondValue, BasicBlock *BB,
+                             BasicBlock *IfBB, BasicBlock *ElseBB) {
+  Value *CondPass = emitCondValue(CondValue);
+  if (CondPass != nullptr)
+    IRB.CreateCondBr(CondPass, IfBB, ElseBB);
+}
+
+// Emit the value defined by the predicated instruction Node as a select
+// between PredVal, the value computed by Node, and the value held by the
+// destination register when condition CondValue does not hold. This keeps
+// predicated instructions without side effects in straight-line code.
+Value *IREmitter::emitPredicatedValue(SDNode *Node, unsigned CondValue,
+                                      Value *PredVal) {
+  Value *OrigVal = nullptr;
+  if (FuncInfo->ArgValMap.count(FuncInfo->NodeRegMap[Node]) > 0)
+    OrigVal = FuncInfo->ArgValMap[FuncInfo->NodeRegMap[Node]];
+  else
+    OrigVal = ConstantInt::get(getDefaultType(), 0, true);
+
+  Value *CondPass = emitCondValue(CondValue);
+  assert(CondPass != nullptr &&
+         "Unhandled condition code of predicated instruction");
+  // Treat the instruction as unpredicated if its condition is not known.
+  Value *Inst = (CondPass != nullptr)
+                    ? IRB.CreateSelect(CondPass, PredVal, OrigVal)
+                    : PredVal;
+  DAGInfo->setRealValue(Node, Inst);
+  FuncInfo->ArgValMap[FuncInfo->NodeRegMap[Node]] = Inst;
+  return Inst;
 }
 
 /// Create PHINode for value use selection when running.
@@ -275,20 +320,20 @@ void IREmitter::emitCPSR(Value *Operand0, Value *Operand1, BasicBlock *BB,
   // Update N flag.
   Value *N_Flag = IRB.CreateLShr(Result, IRB.getInt32(31));
   Value *NTrunc = IRB.CreateTrunc(N_Flag, Ty);
-  IRB.CreateStore(NTrunc, FuncInfo->AllocaMap[0]);
+  storeFlag(0, NTrunc);
 
   // Update Z flag.
   Value *Z_Flag = IRB.CreateICmpEQ(Result, IRB.getInt32(0));
   Value *ZTrunc = IRB.CreateTrunc(Z_Flag, Ty);
-  IRB.CreateStore(ZTrunc, FuncInfo->AllocaMap[1]);
+  storeFlag(1, ZTrunc);
 
   // Update C flag.
   Value *C_Flag = ExtractValueInst::Create(Unsigned_Sum, 1, "", BB);
-  IRB.CreateStore(C_Flag, FuncInfo->AllocaMap[2]);
+  storeFlag(2, C_Flag);
 
   // Update V flag.
   Value *V_Flag = ExtractValueInst::Create(Signed_Sum, 1, "", BB);
-  IRB.CreateStore(V_Flag, FuncInfo->AllocaMap[3]);
+  storeFlag(3, V_Flag);
 }
 
 void IREmitter::emitSpecialCPSR(Value *Result, BasicBlock *BB, unsigned Flag) {
@@ -296,11 +341,11 @@ void IREmitter::emitSpecialCPSR(Value *Result, BasicBlock *BB, unsigned Flag) {
   // Update N flag.
   Value *N_Flag = IRB.CreateLShr(Result, IRB.getInt32(31));
   N_Flag = IRB.CreateTrunc(N_Flag, Ty);
-  IRB.CreateStore(N_Flag, FuncInfo->AllocaMap[0]);
+  storeFlag(0, N_Flag);
   // Update Z flag.
   Value *Z_Flag = IRB.CreateICmpEQ(Result, IRB.getInt32(0));
 
-  IRB.CreateStore(Z_Flag, FuncInfo->AllocaMap[1]);
+  storeFlag(1, Z_Flag);
 }
 
 Type *IREmitter::getIntTypeByPtr(Type *pty) {
@@ -336,12 +381,10 @@ Type *IREmitter::getIntTypeByPtr(Type *pty) {
   DAGInfo->setRealValue(Node, Phi);                                            \
   FuncInfo->ArgValMap[FuncInfo->NodeRegMap[Node]] = Phi;
 
+// Predicated instructions that neither update CPSR nor have side effects are
+// emitted as straight-line code selecting the result by condition code.
 #define HANDLE_EMIT_CONDCODE(OPC)                                              \
-  HANDLE_EMIT_CONDCODE_COMMON(OPC)                                             \
-                                                                               \
-  IRB.SetInsertPoint(IfBB);                                                    \
-  IRB.CreateBr(ElseBB);                                                        \
-  IRB.SetInsertPoint(ElseBB);
+  emitPredicatedValue(Node, CondValue, IRB.Create##OPC(S0, S1));
 
 void IREmitter::emitBinaryCPSR(Value *Inst, BasicBlock *BB, unsigned Opcode,
                                SDNode *Node) {
@@ -390,7 +433,7 @@ void IREmitter::emitBinaryCPSR(Value *Inst, BasicBlock *BB, unsigned Opcode,
     C_Flag = IRB.CreateLShr(C_Flag, IRB.getInt32(31));
     Value *CTrunc = IRB.CreateTrunc(C_Flag, Ty);
 
-    IRB.CreateStore(CTrunc, FuncInfo->AllocaMap[2]);
+    storeFlag(2, CTrunc);
   } break;
   case Instruction::LShr: {
     emitSpecialCPSR(Inst, BB, 0);
@@ -404,7 +447,7 @@ void IREmitter::emitBinaryCPSR(Value *Inst, BasicBlock *BB, unsigned Opcode,
     C_Flag = IRB.CreateAnd(C_Flag, Val);
     Value *CTrunc = IRB.CreateTrunc(C_Flag, Ty);
 
-    IRB.CreateStore(CTrunc, FuncInfo->AllocaMap[2]);
+    storeFlag(2, CTrunc);
   } break;
   case Instruction::AShr: {
     emitSpecialCPSR(Inst, BB, 0);
@@ -417,7 +460,7 @@ void IREmitter::emitBinaryCPSR(Value *Inst, BasicBlock *BB, unsigned Opcode,
     C_Flag = IRB.CreateAShr(S0, C_Flag);
     C_Flag = IRB.CreateAnd(C_Flag, Val);
     Value *CTrunc = IRB.CreateTrunc(C_Flag, Ty);
-    IRB.CreateStore(CTrunc, FuncInfo->AllocaMap[2]);
+    storeFlag(2, CTrunc);
   } break;
   }
 }
@@ -854,24 +897,11 @@ void IREmitter::emitSpecialNode(SDNode *Node) {
 
         emitSpecialCPSR(Inst, BB, 0);
       } else {
-        // Create new BB for EQ instructin exectute.
-        BasicBlock *IfBB = BasicBlock::Create(*CTX, "", BB->getParent());
-        // Create new BB to update the DAG BB.
-        BasicBlock *ElseBB = BasicBlock::Create(*CTX, "", BB->getParent());
-
-        // Emit the condition code.
-        emitCondCode(CondValue, BB, IfBB, ElseBB);
-        IRB.SetInsertPoint(IfBB);
         Value *InstSub = IRB.CreateSub(Val, S1);
         Value *InstLShr = IRB.CreateLShr(S0, S1);
         Value *InstShl = IRB.CreateShl(S0, InstSub);
         Value *Inst = IRB.CreateOr(InstLShr, InstShl);
-        PHINode *Phi = createAndEmitPHINode(Node, BB, IfBB, ElseBB,
-                                            dyn_cast<Instruction>(Inst));
-        DAGInfo->setRealValue(Node, Phi);
-        FuncInfo->ArgValMap[FuncInfo->NodeRegMap[Node]] = Phi;
-        IRB.CreateBr(ElseBB);
-        IRB.SetInsertPoint(ElseBB);
+        emitPredicatedValue(Node, CondValue, Inst);
       }
     } else {
       Value *InstSub = IRB.CreateSub(Val, S1);
@@ -892,7 +922,7 @@ void IREmitter::emitSpecialNode(SDNode *Node) {
 
       if (DAGInfo->NPMap[Node]->UpdateCPSR) {
         Value *InstLShr = IRB.CreateLShr(S0, Val1);
-        Value *C_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[2]);
+        Value *C_Flag = loadFlag(2);
         C_Flag = IRB.CreateZExt(C_Flag, Ty);
         Value *Bit31 = IRB.CreateShl(C_Flag, Val2);
         Value *Inst = IRB.CreateAdd(InstLShr, Bit31);
@@ -904,33 +934,18 @@ void IREmitter::emitSpecialNode(SDNode *Node) {
         // Update C flag.
         // c flag = s0[0]
         C_Flag = IRB.CreateAnd(S0, Val1);
-        IRB.CreateStore(C_Flag, FuncInfo->AllocaMap[2]);
+        storeFlag(2, C_Flag);
       } else {
-        // Create new BB for EQ instructin exectute.
-        BasicBlock *IfBB = BasicBlock::Create(*CTX, "", BB->getParent());
-        // Create new BB to update the DAG BB.
-        BasicBlock *ElseBB = BasicBlock::Create(*CTX, "", BB->getParent());
-
-        // Emit the condition code.
-        emitCondCode(CondValue, BB, IfBB, ElseBB);
-        IRB.SetInsertPoint(IfBB);
         Value *InstLShr = IRB.CreateLShr(S0, Val1);
-        Value *C_Flag = nullptr;
-
-        C_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[2]);
+        Value *C_Flag = loadFlag(2);
         C_Flag = IRB.CreateZExt(C_Flag, Ty);
         Value *Bit31 = IRB.CreateShl(C_Flag, Val2);
         Value *Inst = IRB.CreateAdd(InstLShr, Bit31);
-        PHINode *Phi = createAndEmitPHINode(Node, BB, IfBB, ElseBB,
-                                            dyn_cast<Instruction>(Inst));
-        DAGInfo->setRealValue(Node, Phi);
-        FuncInfo->ArgValMap[FuncInfo->NodeRegMap[Node]] = Phi;
-        IRB.CreateBr(ElseBB);
-        IRB.SetInsertPoint(ElseBB);
+        emitPredicatedValue(Node, CondValue, Inst);
       }
     } else {
       Value *InstLShr = IRB.CreateLShr(S0, Val1);
-      Value *C_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[2]);
+      Value *C_Flag = loadFlag(2);
       C_Flag = IRB.CreateZExt(C_Flag, Ty);
       Value *Bit31 = IRB.CreateShl(C_Flag, Val2);
       Value *Inst = IRB.CreateAdd(InstLShr, Bit31);
@@ -961,22 +976,9 @@ void IREmitter::emitSpecialNode(SDNode *Node) {
         // Update V flag.
         // unchanged.
       } else {
-        // Create new BB for EQ instructin exectute.
-        BasicBlock *IfBB = BasicBlock::Create(*CTX, "", BB->getParent());
-        // Create new BB to update the DAG BB.
-        BasicBlock *ElseBB = BasicBlock::Create(*CTX, "", BB->getParent());
-        // Emit the condition code.
-        emitCondCode(CondValue, BB, IfBB, ElseBB);
-        IRB.SetInsertPoint(IfBB);
         Value *InstXor = IRB.CreateXor(val, S1);
         Value *Inst = IRB.CreateAnd(S0, InstXor);
-        PHINode *Phi = createAndEmitPHINode(Node, BB, IfBB, ElseBB,
-                                            dyn_cast<Instruction>(Inst));
-        DAGInfo->setRealValue(Node, Phi);
-        FuncInfo->ArgValMap[FuncInfo->NodeRegMap[Node]] = Phi;
-
-        IRB.CreateBr(ElseBB);
-        IRB.SetInsertPoint(ElseBB);
+        emitPredicatedValue(Node, CondValue, Inst);
       }
     } else {
       Value *InstXor, *Inst;
@@ -1067,7 +1069,7 @@ void IREmitter::emitSpecialNode(SDNode *Node) {
       if (DAGInfo->NPMap[Node]->UpdateCPSR) {
         Value *InstSub = IRB.CreateSub(S1, S2);
         Value *C_Flag = nullptr;
-        C_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[2]);
+        C_Flag = loadFlag(2);
         Value *CZext = IRB.CreateZExt(C_Flag, Ty);
         Value *InstSBC = IRB.CreateAdd(InstSub, CZext);
         DAGInfo->setRealValue(Node, InstSBC);
@@ -1077,29 +1079,16 @@ void IREmitter::emitSpecialNode(SDNode *Node) {
         else
           emitCPSR(S1, InstNot, BB, 1);
       } else {
-        BasicBlock *IfBB = BasicBlock::Create(*CTX, "", BB->getParent());
-        BasicBlock *ElseBB = BasicBlock::Create(*CTX, "", BB->getParent());
-
-        emitCondCode(CondValue, BB, IfBB, ElseBB);
-
-        IRB.SetInsertPoint(IfBB);
         Value *InstSub = IRB.CreateSub(S1, S2);
-        Value *C_Flag = nullptr;
-        C_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[2]);
+        Value *C_Flag = loadFlag(2);
         Value *CZext = IRB.CreateZExt(C_Flag, Ty);
         Value *Inst = IRB.CreateAdd(InstSub, CZext);
-        PHINode *Phi = createAndEmitPHINode(Node, BB, IfBB, ElseBB,
-                                            dyn_cast<Instruction>(Inst));
-        DAGInfo->setRealValue(Node, Phi);
-        FuncInfo->ArgValMap[FuncInfo->NodeRegMap[Node]] = Phi;
-
-        IRB.CreateBr(ElseBB);
-        IRB.SetInsertPoint(ElseBB);
+        emitPredicatedValue(Node, CondValue, Inst);
       }
     } else {
       Value *InstSub = IRB.CreateSub(S1, S2);
       Value *C_Flag = nullptr;
-      C_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[2]);
+      C_Flag = loadFlag(2);
       Value *CZext = IRB.CreateZExt(C_Flag, Ty);
       Value *InstSBC = IRB.CreateAdd(InstSub, CZext);
       DAGInfo->setRealValue(Node, InstSBC);
@@ -1145,19 +1134,19 @@ void IREmitter::emitSpecialNode(SDNode *Node) {
       // Update N Flag.
       Value *N_Cmp = IRB.getInt32(8);
       Value *N_Flag = IRB.CreateICmpEQ(Shift, N_Cmp);
-      IRB.CreateStore(N_Flag, FuncInfo->AllocaMap[0]);
+      storeFlag(0, N_Flag);
       // Update Z Flag.
       Value *Z_Cmp = IRB.getInt32(4);
       Value *Z_Flag = IRB.CreateICmpEQ(Shift, Z_Cmp);
-      IRB.CreateStore(Z_Flag, FuncInfo->AllocaMap[1]);
+      storeFlag(1, Z_Flag);
       // Update C Flag.
       Value *C_Cmp = IRB.getInt32(2);
       Value *C_Flag = IRB.CreateICmpEQ(Shift, C_Cmp);
-      IRB.CreateStore(C_Flag, FuncInfo->AllocaMap[2]);
+      storeFlag(2, C_Flag);
       // Update V Flag.
       Value *V_Cmp = IRB.getInt32(1);
       Value *V_Flag = IRB.CreateICmpEQ(Shift, V_Cmp);
-      IRB.CreateStore(V_Flag, FuncInfo->AllocaMap[3]);
+      storeFlag(3, V_Flag);
     } else {
       // Pattern msr CSR_f, #const.
     }
@@ -1173,10 +1162,10 @@ void IREmitter::emitSpecialNode(SDNode *Node) {
     Value *BitCShift = IRB.getInt32(29);
     Value *BitVShift = IRB.getInt32(28);
 
-    Value *N_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[0]);
-    Value *Z_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[1]);
-    Value *C_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[2]);
-    Value *V_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[3]);
+    Value *N_Flag = loadFlag(0);
+    Value *Z_Flag = loadFlag(1);
+    Value *C_Flag = loadFlag(2);
+    Value *V_Flag = loadFlag(3);
 
     N_Flag = IRB.CreateZExt(N_Flag, Ty);
     Z_Flag = IRB.CreateZExt(Z_Flag, Ty);
@@ -1210,7 +1199,7 @@ void IREmitter::emitSpecialNode(SDNode *Node) {
 
       if (DAGInfo->NPMap[Node]->UpdateCPSR) {
         // Create add emit.
-        Value *C_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[2]);
+        Value *C_Flag = loadFlag(2);
         Value *Result = IRB.CreateAdd(S0, S1);
         Value *CZext = IRB.CreateZExt(C_Flag, OperandTy);
         Value *InstADC = IRB.CreateAdd(Result, CZext);
@@ -1226,29 +1215,14 @@ void IREmitter::emitSpecialNode(SDNode *Node) {
         else
           emitCPSR(S0, S1, BB, 0);
       } else {
-        // Create new BB for EQ instructin exectute.
-        BasicBlock *IfBB = BasicBlock::Create(*CTX, "", BB->getParent());
-        // Create new BB to update the DAG BB.
-        BasicBlock *ElseBB = BasicBlock::Create(*CTX, "", BB->getParent());
-
-        // Emit the condition code.
-        emitCondCode(CondValue, BB, IfBB, ElseBB);
-
-        Value *C_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[2]);
-        IRB.SetInsertPoint(IfBB);
+        Value *C_Flag = loadFlag(2);
         Value *InstAdd = IRB.CreateAdd(S0, S1);
         Value *CZext = IRB.CreateZExtOrTrunc(C_Flag, OperandTy);
         Value *Inst = IRB.CreateAdd(InstAdd, CZext);
-        PHINode *Phi = createAndEmitPHINode(Node, BB, IfBB, ElseBB,
-                                            dyn_cast<Instruction>(Inst));
-        DAGInfo->setRealValue(Node, Phi);
-        FuncInfo->ArgValMap[FuncInfo->NodeRegMap[Node]] = Phi;
-
-        IRB.CreateBr(ElseBB);
-        IRB.SetInsertPoint(ElseBB);
+        emitPredicatedValue(Node, CondValue, Inst);
       }
     } else {
-      Value *C_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[2]);
+      Value *C_Flag = loadFlag(2);
       Value *Inst = IRB.CreateAdd(S0, S1);
       Value *CTrunc = IRB.CreateZExtOrTrunc(C_Flag, getDefaultType());
       Value *InstADC = IRB.CreateAdd(Inst, CTrunc);
@@ -1261,7 +1235,7 @@ void IREmitter::emitSpecialNode(SDNode *Node) {
     Value *S0 = getIRValue(Node->getOperand(0));
     Value *S1 = getIRValue(Node->getOperand(1));
 
-    Value *C_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[2]);
+    Value *C_Flag = loadFlag(2);
     Value *CZext = IRB.CreateZExt(C_Flag, getDefaultType());
 
     Value *Inst = IRB.CreateAdd(S0, CZext);
@@ -65,12 +65,21 @@ private:
   void emitSpecialNode(SDNode *Node);
   void emitCondCode(unsigned CondValue, BasicBlock *BB, BasicBlock *IfBB,
                     BasicBlock *ElseBB);
+  /// Compute the i1 value of condition code CondValue from the flags.
+  Value *emitCondValue(unsigned CondValue);
+  /// Select the value defined by a predicated instruction without
+  /// branching around it.
+  Value *emitPredicatedValue(SDNode *Node, unsigned CondValue, Value *PredVal);
   void emitBinaryCPSR(Value *Inst, BasicBlock *BB, unsigned Opcode,
                       SDNode *Node);
   /// Update the N Z C V flags of global variable.
   void emitCPSR(Value *Operand0, Value *Operand1, BasicBlock *BB,
                 unsigned Flag);
   void emitSpecialCPSR(Value *Result, BasicBlock *BB, unsigned Flag);
+  /// Get the current value of the NZCV flag with index Flag.
+  Value *loadFlag(unsigned Flag);
+  /// Set the NZCV flag with index Flag, if the flag is ever read.
+  void storeFlag(unsigned Flag, Value *Val);
   /// Create PHINode for value use selection when running.
   PHINode *createAndEmitPHINode(SDNode *Node, BasicBlock *BB, BasicBlock *IfBB,
                                 BasicBlock *ElseBB, Instruction *IfInst);
@@ -0,0 +1,105 @@
+//===-- BranchProfile.cpp ---------------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file builds the table of control transfer counts of the input binary
+// from user-specified input via --profile option.
+//
+//===----------------------------------------------------------------------===//
+
+#include "BranchProfile.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/IR/MDBuilder.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+#define DEBUG_TYPE "mctoll"
+
+std::map<std::pair<uint64_t, uint64_t>, uint64_t> BranchProfile::EdgeCounts;
+DenseMap<uint64_t, uint64_t> BranchProfile::TargetCounts;
+
+bool BranchProfile::readProfile(StringRef FileName) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> BufOrErr =
+      MemoryBuffer::getFile(FileName);
+  if (!BufOrErr) {
+    errs() << "Unable to read profile " << FileName << ": "
+           << BufOrErr.getError().message() << "\n";
+    return false;
+  }
+
+  SmallVector<StringRef, 16> Lines;
+  (*BufOrErr)->getBuffer().split(Lines, '\n', -1, false);
+  unsigned LineNo = 0;
+  for (StringRef Line : Lines) {
+    LineNo++;
+    Line = Line.trim();
+    if (Line.empty() || Line.startswith("#"))
+      continue;
+
+    SmallVector<StringRef, 3> Fields;
+    SplitString(Line, Fields);
+    uint64_t From, To, Count;
+    // Radix 0 accepts both 0x-prefixed hexadecimal and decimal values.
+    if (Fields.size() != 3 || Fields[0].getAsInteger(0, From) ||
+        Fields[1].getAsInteger(0, To) || Fields[2].getAsInteger(0, Count)) {
+      errs() << FileName << ":" << LineNo << ": malformed profile entry\n";
+      EdgeCounts.clear();
+      TargetCounts.clear();
+      return false;
+    }
+    EdgeCounts[std::make_pair(From, To)] += Count;
+    TargetCounts[To] += Count;
+  }
+  LLVM_DEBUG(dbgs() << "Read " << EdgeCounts.size() << " profile edges from "
+                    << FileName << "\n");
+  return true;
+}
+
+uint64_t BranchProfile::getEdgeCount(uint64_t From, uint64_t To) {
+  auto Iter = EdgeCounts.find(std::make_pair(From, To));
+  return (Iter == EdgeCounts.end()) ? 0 : Iter->second;
+}
+
+uint64_t BranchProfile::getTargetCount(uint64_t Addr) {
+  auto Iter = TargetCounts.find(Addr);
+  return (Iter == TargetCounts.end()) ? 0 : Iter->second;
+}
+
+MDNode *BranchProfile::getBranchWeights(LLVMContext &Ctx, uint64_t From,
+                                        ArrayRef<uint64_t> Targets) {
+  SmallVector<uint64_t, 4> Counts;
+  for (uint64_t To : Targets)
+    Counts.push_back(getEdgeCount(From, To));
+  return createBranchWeights(Ctx, Counts);
+}
+
+MDNode *BranchProfile::getIndirectBranchWeights(LLVMContext &Ctx,
+                                                ArrayRef<uint64_t> Targets) {
+  SmallVector<uint64_t, 16> Counts;
+  for (uint64_t To : Targets)
+    Counts.push_back(getTargetCount(To));
+  return createBranchWeights(Ctx, Counts);
+}
+
+MDNode *BranchProfile::createBranchWeights(LLVMContext &Ctx,
+                                           ArrayRef<uint64_t> Counts) {
+  uint64_t MaxCount = 0;
+  for (uint64_t Count : Counts)
+    MaxCount = std::max(MaxCount, Count);
+  if (MaxCount == 0)
+    return nullptr;
+
+  // Branch weights are 32-bit; scale all counts alike if any does not fit.
+  uint64_t Scale = MaxCount / UINT32_MAX + 1;
+  SmallVector<uint32_t, 4> Weights;
+  for (uint64_t Count : Counts)
+    Weights.push_back(static_cast<uint32_t>(Count / Scale));
+  return MDBuilder(Ctx).createBranchWeights(Weights);
+}
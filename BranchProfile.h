@@ -0,0 +1,69 @@
+//===-- BranchProfile.h -----------------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the table of control transfer counts of the input binary
+// read from the file specified via the --profile option.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TOOLS_LLVM_MCTOLL_BRANCHPROFILE_H
+#define LLVM_TOOLS_LLVM_MCTOLL_BRANCHPROFILE_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Metadata.h"
+#include <map>
+#include <utility>
+
+using namespace llvm;
+
+class BranchProfile {
+  BranchProfile(){};
+  ~BranchProfile(){};
+
+public:
+  // Read the profile in FileName. Each line of the file records a control
+  // transfer from the instruction at one address of the input binary to
+  // another and the number of times it was observed:
+  //   <from-address> <to-address> <count>
+  // Fall-through edges of conditional branches are recorded with the address
+  // of the instruction following the branch as <to-address>. Empty lines and
+  // lines starting with '#' are ignored. Return false if the file can not be
+  // read or is malformed.
+  static bool readProfile(StringRef FileName);
+
+  static bool empty() { return EdgeCounts.empty(); }
+
+  // Number of transfers from the instruction at From to To.
+  static uint64_t getEdgeCount(uint64_t From, uint64_t To);
+
+  // Number of transfers to the instruction at Addr from anywhere.
+  static uint64_t getTargetCount(uint64_t Addr);
+
+  // Return branch weights metadata for a branch at address From to each of
+  // Targets, or nullptr if no transfer from From was recorded.
+  static MDNode *getBranchWeights(LLVMContext &Ctx, uint64_t From,
+                                  ArrayRef<uint64_t> Targets);
+
+  // Return branch weights metadata for an indirect branch to each of Targets
+  // based on the number of transfers to them, or nullptr if none of Targets
+  // was reached.
+  static MDNode *getIndirectBranchWeights(LLVMContext &Ctx,
+                                          ArrayRef<uint64_t> Targets);
+
+private:
+  static MDNode *createBranchWeights(LLVMContext &Ctx,
+                                     ArrayRef<uint64_t> Counts);
+
+  static std::map<std::pair<uint64_t, uint64_t>, uint64_t> EdgeCounts;
+  static DenseMap<uint64_t, uint64_t> TargetCounts;
+};
+
+#endif // LLVM_TOOLS_LLVM_MCTOLL_BRANCHPROFILE_H
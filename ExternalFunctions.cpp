@@ -16,12 +16,18 @@
 #include "clang/AST/RecursiveASTVisitor.h"
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/FrontendActions.h"
-#include "clang/Tooling/CommonOptionsParser.h"
 #include "clang/Tooling/CompilationDatabase.h"
 #include "clang/Tooling/Tooling.h"
+#include "llvm/Support/DataExtractor.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/xxhash.h"
 #include "llvm/Support/raw_ostream.h"
 #include <clang-c/Index.h>
+#include <algorithm>
 #include <memory>
 #include <sstream>
 #include <string>
@@ -35,15 +41,20 @@
 std::map<std::string, ExternalFunctions::RetAndArgs>
     ExternalFunctions::UserSpecifiedFunctions;
 
+// Table of function prototypes keyed by function name.
+using PrototypeTable = std::map<std::string, ExternalFunctions::RetAndArgs>;
+
 // FuncDeclVisitor
 
+// Visitor adding the prototypes of the function declarations it visits to a
+// table. Include files are parsed concurrently, each into its own table.
 class FuncDeclVisitor : public clang::RecursiveASTVisitor<FuncDeclVisitor> {
   clang::ASTContext &Context;
+  PrototypeTable &Prototypes;
 
 public:
-  FuncDeclVisitor(clang::ASTContext &Context) : Context(Context) {
-    llvm::setCurrentDebugType(DEBUG_TYPE);
-  }
+  FuncDeclVisitor(clang::ASTContext &Context, PrototypeTable &Prototypes)
+      : Context(Context), Prototypes(Prototypes) {}
 
   bool VisitFunctionDecl(clang::FunctionDecl *FuncDecl) {
     ExternalFunctions::RetAndArgs Entry;
@@ -62,18 +73,16 @@ public:
     // function name to detect duplicate function prototype specification. Need
     // to update this check to include argument types when support to raise C++
     // binary is added.
-    if (ExternalFunctions::UserSpecifiedFunctions.find(
-            FuncDecl->getQualifiedNameAsString()) !=
-        ExternalFunctions::UserSpecifiedFunctions.end()) {
+    if (Prototypes.find(FuncDecl->getQualifiedNameAsString()) !=
+        Prototypes.end()) {
       LLVM_DEBUG(dbgs() << FuncDecl->getQualifiedNameAsString()
                         << " : Ignoring duplicate entry in "
                         << Context.getSourceManager().getFilename(
                                FuncDecl->getLocation())
                         << "\n");
     } else {
-      ExternalFunctions::UserSpecifiedFunctions.insert(
-          std::pair<std::string, ExternalFunctions::RetAndArgs>(
-              FuncDecl->getQualifiedNameAsString(), Entry));
+      Prototypes.insert(std::make_pair(FuncDecl->getQualifiedNameAsString(),
+                                       Entry));
     }
     return true;
   }
@@ -146,15 +155,27 @@ private:
   }
 };
 
+// Consumer adding the prototypes of the functions declared in the main file
+// to a table, and the names of all files read while parsing it, including
+// the main file, to Files.
 class FuncDeclFinder : public clang::ASTConsumer {
   FuncDeclVisitor Visitor;
+  std::vector<std::string> &Files;
 
 public:
-  FuncDeclFinder(clang::ASTContext &Context) : Visitor(Context) {}
+  FuncDeclFinder(clang::ASTContext &Context, PrototypeTable &Prototypes,
+                 std::vector<std::string> &Files)
+      : Visitor(Context, Prototypes), Files(Files) {}
 
   void HandleTranslationUnit(clang::ASTContext &Context) final {
     auto Decls = Context.getTranslationUnitDecl()->decls();
     clang::SourceManager &SourceManager(Context.getSourceManager());
+    // Prototypes depend on the declarations of the types they use, which may
+    // come from any file included.
+    for (auto I = SourceManager.fileinfo_begin(),
+              E = SourceManager.fileinfo_end();
+         I != E; ++I)
+      Files.push_back(I->first->getName().str());
     for (auto &Decl : Decls) {
       if (!Decl->isFunctionOrFunctionTemplate())
         continue;
@@ -168,15 +189,92 @@ public:
 };
 
 class FuncDeclFindingAction : public clang::ASTFrontendAction {
+  PrototypeTable &Prototypes;
+  std::vector<std::string> &Files;
+
 public:
+  FuncDeclFindingAction(PrototypeTable &Prototypes,
+                        std::vector<std::string> &Files)
+      : Prototypes(Prototypes), Files(Files) {}
+
   std::unique_ptr<clang::ASTConsumer>
   CreateASTConsumer(clang::CompilerInstance &CI,
                     clang::StringRef InFile) final {
     return std::unique_ptr<clang::ASTConsumer>(
-        new FuncDeclFinder(CI.getASTContext()));
+        new FuncDeclFinder(CI.getASTContext(), Prototypes, Files));
+  }
+};
+
+class FuncDeclFindingActionFactory
+    : public clang::tooling::FrontendActionFactory {
+  PrototypeTable &Prototypes;
+  std::vector<std::string> &Files;
+
+public:
+  FuncDeclFindingActionFactory(PrototypeTable &Prototypes,
+                               std::vector<std::string> &Files)
+      : Prototypes(Prototypes), Files(Files) {}
+
+  std::unique_ptr<clang::FrontendAction> create() final {
+    return std::make_unique<FuncDeclFindingAction>(Prototypes, Files);
   }
 };
 
+namespace {
+// Built-in prototype of a C library function.
+struct LibcPrototype {
+  const char *Name;
+  const char *ReturnType;
+  const char *Arguments;
+  bool IsVariadic;
+};
+} // namespace
+
+static constexpr LibcPrototype LibcPrototypes[] = {
+#define LIBC_PROTOTYPE(NAME, RET, ARGS, VARIADIC) {#NAME, RET, ARGS, VARIADIC},
+#include "LibcPrototypes.def"
+};
+
+static constexpr bool isNameLess(const char *A, const char *B) {
+  while (*A != '\0' && *A == *B) {
+    ++A;
+    ++B;
+  }
+  return static_cast<unsigned char>(*A) < static_cast<unsigned char>(*B);
+}
+
+static constexpr bool isSortedByName(const LibcPrototype *Begin,
+                                     const LibcPrototype *End) {
+  for (const LibcPrototype *P = Begin; P + 1 < End; ++P)
+    if (!isNameLess(P->Name, (P + 1)->Name))
+      return false;
+  return true;
+}
+
+static_assert(isSortedByName(std::begin(LibcPrototypes),
+                             std::end(LibcPrototypes)),
+              "LibcPrototypes.def must be sorted by name");
+
+// Return the built-in prototype of C library function Name in Entry. Return
+// false if there is none.
+static bool getLibcPrototype(StringRef Name,
+                             ExternalFunctions::RetAndArgs &Entry) {
+  const LibcPrototype *P = std::lower_bound(
+      std::begin(LibcPrototypes), std::end(LibcPrototypes), Name,
+      [](const LibcPrototype &P, StringRef Name) { return P.Name < Name; });
+  if (P == std::end(LibcPrototypes) || Name != P->Name)
+    return false;
+
+  SmallVector<StringRef, 8> Args;
+  StringRef(P->Arguments).split(Args, ',', -1, /*KeepEmpty=*/false);
+  Entry.ReturnType = P->ReturnType;
+  Entry.Arguments.clear();
+  for (StringRef Arg : Args)
+    Entry.Arguments.push_back(Arg.str());
+  Entry.isVariadic = P->IsVariadic;
+  return true;
+}
+
 // Construct and return a Function* corresponding to a known external function
 Function *ExternalFunctions::Create(StringRef &CFuncName, ModuleRaiser &MR) {
   Module *M = MR.getModule();
@@ -188,24 +286,25 @@ Function *ExternalFunctions::Create(StringRef &CFuncName, ModuleRaiser &MR) {
 
   auto iter = ExternalFunctions::UserSpecifiedFunctions.find(CFuncName.str());
   if (iter == ExternalFunctions::UserSpecifiedFunctions.end()) {
-    errs() << "Unknown prototype for function : " << CFuncName.data() << "\n";
-    errs() << "Use -I </full/path/to/file>, where /full/path/to/file declares "
-              "its prototype\n";
-    return nullptr;
+    // Fall back to the built-in prototype of a C library function.
+    ExternalFunctions::RetAndArgs Entry;
+    if (!getLibcPrototype(CFuncName, Entry)) {
+      errs() << "Unknown prototype for function : " << CFuncName.data()
+             << "\n";
+      errs() << "Use -I </full/path/to/file>, where /full/path/to/file "
+                "declares its prototype\n";
+      return nullptr;
+    }
+    iter = ExternalFunctions::UserSpecifiedFunctions
+               .insert(std::make_pair(CFuncName.str(), Entry))
+               .first;
   }
 
   const ExternalFunctions::RetAndArgs &retAndArgs = iter->second;
-  Type *RetType =
-      MR.getFunctionFilter()->getPrimitiveDataType(retAndArgs.ReturnType);
-  std::vector<Type *> ArgVec;
-  for (StringRef arg : retAndArgs.Arguments) {
-    Type *argType = MR.getFunctionFilter()->getPrimitiveDataType(arg);
-    ArgVec.push_back(argType);
-  }
-
-  ArrayRef<Type *> Args(ArgVec);
-  if (llvm::FunctionType *FuncType =
-          FunctionType::get(RetType, Args, retAndArgs.isVariadic)) {
+  SmallVector<StringRef, 8> Args(retAndArgs.Arguments.begin(),
+                                 retAndArgs.Arguments.end());
+  if (llvm::FunctionType *FuncType = MR.getFunctionFilter()->getFunctionType(
+          retAndArgs.ReturnType, Args, retAndArgs.isVariadic)) {
     FunctionCallee FunCallee = M->getOrInsertFunction(CFuncName, FuncType);
     assert(isa<Function>(FunCallee.getCallee()) && "Expect Function");
     Func = reinterpret_cast<Function *>(FunCallee.getCallee());
@@ -222,45 +321,317 @@ Function *ExternalFunctions::Create(StringRef &CFuncName, ModuleRaiser &MR) {
   return nullptr;
 }
 
-bool ExternalFunctions::getUserSpecifiedFuncPrototypes(
-    std::vector<std::string> &FileNames) {
-  static llvm::cl::OptionCategory InclFileParseCategory("my-tool options");
-  // 3 arguments viz., "dummy-tool IncludeFileName --", with no -debug
-  // 4 arguments viz., "dummy-tool IncludeFileName -debug --", with -debug
-  const int ToolArgc = llvm::DebugFlag ? 4 : 3;
-  const char **ToolArgv = new const char *[ToolArgc];
-  ToolArgv[0] = "dummy-tool";
-  if (llvm::DebugFlag)
-    ToolArgv[ToolArgc - 2] = "-debug";
-  ToolArgv[ToolArgc - 1] = "--";
-
-  // Add each include file as second argument to parse it for function
-  // declarations.
-  for (auto FileName : FileNames) {
-    // CommandOptionParser constructor can change the contents for its first
-    // argument. Reset it to ToolArgc in preparation for parsing the next
-    // include file.
-    int ArgSz = ToolArgc;
-    ToolArgv[1] = FileName.c_str();
-    clang::tooling::CommonOptionsParser OptParser(
-        ArgSz, const_cast<const char **>(ToolArgv), InclFileParseCategory);
-    clang::tooling::ClangTool Tool(OptParser.getCompilations(),
-                                   OptParser.getSourcePathList());
-
-    int Success = Tool.run(
-        clang::tooling::newFrontendActionFactory<FuncDeclFindingAction>()
-            .get());
-    switch (Success) {
-    case 0:
+// Absolute path, modification time and content hash of a file.
+struct HeaderKey {
+  std::string Path;
+  uint64_t MTime = 0;
+  uint64_t Hash = 0;
+};
+
+// Prototypes declared in a header file, with the keys of the header and of
+// all files it includes, directly or not, when they were read.
+struct HeaderPrototypes {
+  // The header comes first, followed by its includes in order of path.
+  std::vector<HeaderKey> Files;
+  PrototypeTable Prototypes;
+};
+
+// Prototype database of header files, keyed by absolute path. The database
+// file starts with PrototypeDBMagic, followed by the little-endian encoding
+//   u32 NumHeaders
+//   { u32 NumFiles { cstr Path, u64 MTime, u64 Hash }, u32 NumFuncs
+//     { cstr Name, cstr ReturnType, u8 IsVariadic, u32 NumArgs
+//       { cstr Argument } } }
+using PrototypeDBMap = std::map<std::string, HeaderPrototypes>;
+static const char PrototypeDBMagic[] = "MCTLPDB2";
+
+// Get the absolute path, modification time and content hash of the file
+// FileName. Return false if the file can not be read.
+static bool getHeaderKey(StringRef FileName, HeaderKey &Key) {
+  SmallString<256> AbsPath(FileName);
+  if (sys::fs::make_absolute(AbsPath))
+    return false;
+  sys::fs::file_status Status;
+  if (sys::fs::status(AbsPath, Status))
+    return false;
+  ErrorOr<std::unique_ptr<MemoryBuffer>> Buf = MemoryBuffer::getFile(AbsPath);
+  if (!Buf)
+    return false;
+  Key.Path = std::string(AbsPath.str());
+  Key.MTime = Status.getLastModificationTime().time_since_epoch().count();
+  Key.Hash = xxHash64((*Buf)->getBuffer());
+  return true;
+}
+
+// Return true if none of the files the prototypes of Header were read from
+// changed since.
+static bool isUpToDate(const HeaderPrototypes &Header) {
+  for (const HeaderKey &File : Header.Files) {
+    HeaderKey Key;
+    if (!getHeaderKey(File.Path, Key) || Key.MTime != File.MTime ||
+        Key.Hash != File.Hash)
+      return false;
+  }
+  return true;
+}
+
+// Read the prototype database DBFile into DB. A missing database is empty.
+// Return false if the database is invalid.
+static bool readPrototypeDB(StringRef DBFile, PrototypeDBMap &DB) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> Buf = MemoryBuffer::getFile(DBFile);
+  if (!Buf)
+    return Buf.getError() == std::errc::no_such_file_or_directory;
+
+  StringRef Data = (*Buf)->getBuffer();
+  if (!Data.startswith(PrototypeDBMagic))
+    return false;
+  DataExtractor DE(Data.drop_front(sizeof(PrototypeDBMagic) - 1),
+                   /*IsLittleEndian=*/true, /*AddressSize=*/8);
+  DataExtractor::Cursor C(0);
+  uint32_t NumHeaders = DE.getU32(C);
+  for (uint32_t I = 0; I < NumHeaders && C; ++I) {
+    HeaderPrototypes Header;
+    uint32_t NumFiles = DE.getU32(C);
+    for (uint32_t J = 0; J < NumFiles && C; ++J) {
+      HeaderKey File;
+      File.Path = std::string(DE.getCStrRef(C));
+      File.MTime = DE.getU64(C);
+      File.Hash = DE.getU64(C);
+      Header.Files.push_back(std::move(File));
+    }
+    uint32_t NumFuncs = DE.getU32(C);
+    for (uint32_t J = 0; J < NumFuncs && C; ++J) {
+      std::string Name(DE.getCStrRef(C));
+      ExternalFunctions::RetAndArgs Entry;
+      Entry.ReturnType = std::string(DE.getCStrRef(C));
+      Entry.isVariadic = DE.getU8(C) != 0;
+      uint32_t NumArgs = DE.getU32(C);
+      for (uint32_t K = 0; K < NumArgs && C; ++K)
+        Entry.Arguments.push_back(std::string(DE.getCStrRef(C)));
+      Header.Prototypes.insert(std::make_pair(Name, Entry));
+    }
+    if (!C || Header.Files.empty())
       break;
-    default:
+    std::string Path = Header.Files.front().Path;
+    DB[Path] = std::move(Header);
+  }
+  if (!C || DB.size() != NumHeaders) {
+    consumeError(C.takeError());
+    DB.clear();
+    return false;
+  }
+  return true;
+}
+
+// Write DB to the prototype database DBFile. The database is replaced
+// atomically, so that concurrent raisers sharing it read either the old or
+// the new one. Return false on failure.
+static bool writePrototypeDB(StringRef DBFile, const PrototypeDBMap &DB) {
+  SmallString<256> TempFile;
+  int FD;
+  if (sys::fs::createUniqueFile(DBFile + ".tmp-%%%%%%", FD, TempFile))
+    return false;
+  {
+    raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    support::endian::Writer W(OS, support::little);
+    auto WriteCStr = [&OS](StringRef S) { OS << S << '\0'; };
+    OS << PrototypeDBMagic;
+    W.write<uint32_t>(DB.size());
+    for (auto &Header : DB) {
+      W.write<uint32_t>(Header.second.Files.size());
+      for (const HeaderKey &File : Header.second.Files) {
+        WriteCStr(File.Path);
+        W.write<uint64_t>(File.MTime);
+        W.write<uint64_t>(File.Hash);
+      }
+      W.write<uint32_t>(Header.second.Prototypes.size());
+      for (auto &Proto : Header.second.Prototypes) {
+        WriteCStr(Proto.first);
+        WriteCStr(Proto.second.ReturnType);
+        W.write<uint8_t>(Proto.second.isVariadic);
+        W.write<uint32_t>(Proto.second.Arguments.size());
+        for (auto &Arg : Proto.second.Arguments)
+          WriteCStr(Arg);
+      }
+    }
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      sys::fs::remove(TempFile);
+      return false;
+    }
+  }
+  if (sys::fs::rename(TempFile, DBFile)) {
+    sys::fs::remove(TempFile);
+    return false;
+  }
+  return true;
+}
+
+// Add Prototypes to the table of user specified function prototypes. The
+// first prototype found for a function is kept.
+static void addPrototypes(const PrototypeTable &Prototypes) {
+  for (auto &Proto : Prototypes)
+    if (!ExternalFunctions::UserSpecifiedFunctions.insert(Proto).second)
+      LLVM_DEBUG(dbgs() << Proto.first << " : Ignoring duplicate entry\n");
+}
+
+// Prototypes read from an include file, its key in the prototype database and
+// the names of the files read while parsing it.
+struct IncludeFilePrototypes {
+  HeaderKey Key;
+  bool HaveKey = false;
+  // Whether the prototypes are read from the prototype database.
+  bool Cached = false;
+  // Result of parsing the include file.
+  int Status = 0;
+  PrototypeTable Prototypes;
+  std::vector<std::string> Files;
+};
+
+bool ExternalFunctions::getUserSpecifiedFuncPrototypes(
+    std::vector<std::string> &FileNames, StringRef PrototypeDB) {
+  PrototypeDBMap DB;
+  if (!PrototypeDB.empty() && !readPrototypeDB(PrototypeDB, DB))
+    errs() << "Ignoring invalid prototype database " << PrototypeDB << "\n";
+
+  // Use the prototypes recorded in the database for include files that did
+  // not change since, nor did any file they include.
+  std::vector<IncludeFilePrototypes> Files(FileNames.size());
+  unsigned NumToParse = 0;
+  for (size_t I = 0, E = FileNames.size(); I != E; ++I) {
+    IncludeFilePrototypes &File = Files[I];
+    File.HaveKey =
+        !PrototypeDB.empty() && getHeaderKey(FileNames[I], File.Key);
+    if (File.HaveKey) {
+      auto Header = DB.find(File.Key.Path);
+      if (Header != DB.end() && isUpToDate(Header->second)) {
+        LLVM_DEBUG(dbgs() << "Read prototypes of " << FileNames[I]
+                          << " from prototype database\n");
+        File.Cached = true;
+        continue;
+      }
+    }
+    ++NumToParse;
+  }
+
+  // Parse the other include files concurrently, each into its own table. The
+  // compilation database is created directly since CommonOptionsParser sets
+  // global command-line options.
+  llvm::setCurrentDebugType(DEBUG_TYPE);
+  if (NumToParse > 0) {
+    ThreadPool Pool(hardware_concurrency(NumToParse));
+    for (size_t I = 0, E = FileNames.size(); I != E; ++I) {
+      if (Files[I].Cached)
+        continue;
+      Pool.async([&FileNames, &Files, I]() {
+        clang::tooling::FixedCompilationDatabase Compilations(
+            ".", std::vector<std::string>());
+        clang::tooling::ClangTool Tool(Compilations, FileNames[I]);
+        FuncDeclFindingActionFactory Factory(Files[I].Prototypes,
+                                             Files[I].Files);
+        Files[I].Status = Tool.run(&Factory);
+      });
+    }
+    Pool.wait();
+  }
+
+  // Merge the tables in the order of the include files, so that the first
+  // declaration of a function wins regardless of parsing order.
+  bool DBChanged = false;
+  for (size_t I = 0, E = FileNames.size(); I != E; ++I) {
+    IncludeFilePrototypes &File = Files[I];
+    if (File.Cached) {
+      addPrototypes(DB[File.Key.Path].Prototypes);
+      continue;
+    }
+    addPrototypes(File.Prototypes);
+    if (File.Status != 0) {
       // TODO : Expand
       dbgs() << "Error\n";
+      continue;
     }
+    if (!File.HaveKey)
+      continue;
+    // Record the header only if all files it includes can be read.
+    HeaderPrototypes Header;
+    Header.Files.push_back(File.Key);
+    bool HaveIncludeKeys = true;
+    for (const std::string &Name : File.Files) {
+      HeaderKey Key;
+      if (!getHeaderKey(Name, Key)) {
+        HaveIncludeKeys = false;
+        break;
+      }
+      if (Key.Path != File.Key.Path)
+        Header.Files.push_back(std::move(Key));
+    }
+    if (!HaveIncludeKeys)
+      continue;
+    std::sort(Header.Files.begin() + 1, Header.Files.end(),
+              [](const HeaderKey &A, const HeaderKey &B) {
+                return A.Path < B.Path;
+              });
+    Header.Prototypes = std::move(File.Prototypes);
+    DB[File.Key.Path] = std::move(Header);
+    DBChanged = true;
   }
 
-  delete[] ToolArgv;
+  if (DBChanged && !writePrototypeDB(PrototypeDB, DB))
+    errs() << "Unable to write prototype database " << PrototypeDB << "\n";
 
   return true;
 }
+
+// Return the type string of Ty as understood by
+// FunctionFilter::getPrimitiveDataType(), or an empty string if Ty can not be
+// expressed as such.
+static std::string getPrimitiveTypeString(Type *Ty) {
+  if (Ty->isPointerTy()) {
+    Type *ElemTy = Ty->getPointerElementType();
+    std::string ElemStr =
+        ElemTy->isPointerTy() ? std::string() : getPrimitiveTypeString(ElemTy);
+    // Pointers to aggregates, functions or pointers are passed as i8*.
+    return (ElemStr.empty() ? std::string("i8") : ElemStr) + "*";
+  }
+  if (Ty->isVoidTy())
+    return "void";
+  if (Ty->isIntegerTy(1) || Ty->isIntegerTy(8) || Ty->isIntegerTy(16) ||
+      Ty->isIntegerTy(32) || Ty->isIntegerTy(64))
+    return "i" + std::to_string(Ty->getIntegerBitWidth());
+  if (Ty->isFloatTy())
+    return "float";
+  if (Ty->isDoubleTy())
+    return "double";
+  if (Ty->isX86_FP80Ty())
+    return "ldouble";
+  return std::string();
+}
+
+void ExternalFunctions::addRaisedFuncPrototypes(const Module &M) {
+  for (const Function &F : M) {
+    if (F.isDeclaration() || F.hasLocalLinkage())
+      continue;
+
+    ExternalFunctions::RetAndArgs Entry;
+    Entry.ReturnType = getPrimitiveTypeString(F.getReturnType());
+    bool Expressible = !Entry.ReturnType.empty();
+    for (Type *ParamTy : F.getFunctionType()->params()) {
+      std::string ParamTyStr = getPrimitiveTypeString(ParamTy);
+      Expressible &= !ParamTyStr.empty() && ParamTyStr != "void";
+      Entry.Arguments.push_back(ParamTyStr);
+    }
+    Entry.isVariadic = F.isVarArg();
+    if (!Expressible) {
+      LLVM_DEBUG(dbgs() << F.getName()
+                        << " : Ignoring raised function with unsupported "
+                           "prototype\n");
+      continue;
+    }
+
+    // std::map::insert keeps the entry of a user-specified prototype.
+    ExternalFunctions::UserSpecifiedFunctions.insert(
+        std::make_pair(F.getName().str(), Entry));
+  }
+}
 #undef DEBUG_TYPE
@@ -34,7 +34,17 @@ public:
   // Table of user specified function prototypes
   static std::map<std::string, ExternalFunctions::RetAndArgs>
       UserSpecifiedFunctions;
-  static bool getUserSpecifiedFuncPrototypes(std::vector<string> &FileNames);
+  // Add the prototypes of functions declared in the include files FileNames
+  // to the table. If PrototypeDB is not empty, the prototypes of an include
+  // file that did not change, nor did any file it includes, since they were
+  // recorded in the prototype database file PrototypeDB are read from it
+  // instead of parsing the file, and those of parsed files are recorded in it.
+  static bool getUserSpecifiedFuncPrototypes(std::vector<string> &FileNames,
+                                             StringRef PrototypeDB = "");
+  // Add the prototypes of functions defined in raised module M with external
+  // linkage to the table, so that calls to them from binaries raised later
+  // are bound to these functions. Prototypes already in the table are kept.
+  static void addRaisedFuncPrototypes(const Module &M);
 };
 
 #endif // LLVM_TOOLS_LLVM_MCTOLL_EXTERNALFUNCTIONS_H
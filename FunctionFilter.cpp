@@ -13,20 +13,20 @@
 //===----------------------------------------------------------------------===//
 
 #include "FunctionFilter.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Regex.h"
 #include <fstream>
 
 FunctionFilter::~FunctionFilter() {
-  if (!ExcludedFunctionVector.empty())
-    for (auto FIE : ExcludedFunctionVector)
-      if (FIE != nullptr)
-        delete FIE;
-
-  if (!IncludedFunctionVector.empty())
-    for (auto FII : IncludedFunctionVector)
-      if (FII != nullptr)
-        delete FII;
+  for (auto FIE : ExcludedFunctions.Functions)
+    if (FIE != nullptr)
+      delete FIE;
+
+  for (auto FII : IncludedFunctions.Functions)
+    if (FII != nullptr)
+      delete FII;
 }
 
 /// Get the data type corresponding to type string. These correspond to type
@@ -71,34 +71,70 @@ Type *FunctionFilter::getPrimitiveDataType(const StringRef &TypeStr) {
   return RetTy;
 }
 
-/// Parse input string as symbol name and function type.
+/// Get the function type with the return and parameter types corresponding
+/// to the type strings. Function types are constructed once per distinct
+/// signature.
+FunctionType *FunctionFilter::getFunctionType(StringRef RetTyStr,
+                                              ArrayRef<StringRef> ParamTyStrs,
+                                              bool IsVarArg) {
+  SmallString<64> Signature(RetTyStr);
+  Signature.push_back('(');
+  for (StringRef ParamTyStr : ParamTyStrs) {
+    Signature.append(ParamTyStr);
+    Signature.push_back(',');
+  }
+  if (IsVarArg)
+    Signature.append("...");
+  Signature.push_back(')');
+
+  FunctionType *&FnTy = FunctionTypes[Signature];
+  if (FnTy != nullptr)
+    return FnTy;
+
+  Type *RetTy = getPrimitiveDataType(RetTyStr);
+  std::vector<Type *> ParamTypes;
+  for (StringRef ParamTyStr : ParamTyStrs)
+    ParamTypes.push_back(getPrimitiveDataType(ParamTyStr));
+  FnTy = FunctionType::get(RetTy, ParamTypes, IsVarArg);
+  return FnTy;
+}
+
+/// Parse input string as symbol name and function type. The prototype is of
+/// the form "<return type> <symbol name>(<comma-separated parameter types>)".
 bool FunctionFilter::parsePrototypeStr(StringRef &InProt,
                                        FunctionFilter::FuncInfo &OutProt) {
-  SmallVector<StringRef, 4> Grp;
-  Regex Rgx("(.+)[ ]+(.+)\\(([[:alnum:] \\*,]*)\\)");
-
-  if (!Rgx.match(InProt, &Grp))
+  // A symbol name pattern may contain parentheses. Use the last ones.
+  size_t ParasEnd = InProt.rfind(')');
+  size_t ParasStart = InProt.rfind('(', ParasEnd);
+  if (ParasStart == StringRef::npos || ParasEnd == StringRef::npos)
     return false;
 
-  StringRef RetStr = Grp[1].trim();  // Get the return type string.
-  StringRef SymName = Grp[2].trim(); // Get the symbol name string.
-  StringRef Paras = Grp[3]; // Get the arguments' string. If no argument,
-                            // it would be "".
+  // Get the arguments' string. If no argument, it would be "".
+  StringRef Paras = InProt.slice(ParasStart + 1, ParasEnd);
+  if (Paras.find_if([](char C) {
+        return !isAlnum(C) && C != ' ' && C != '*' && C != ',' && C != '.';
+      }) != StringRef::npos)
+    return false;
 
-  // Get the function return type.
-  Type *RetTy = getPrimitiveDataType(RetStr);
+  // The symbol name follows the last space before the arguments.
+  StringRef RetAndSym = InProt.take_front(ParasStart).rtrim();
+  size_t SymStart = RetAndSym.find_last_of(' ');
+  if (SymStart == StringRef::npos)
+    return false;
+  StringRef RetStr = RetAndSym.take_front(SymStart).trim();
+  StringRef SymName = RetAndSym.drop_front(SymStart + 1);
+  if (RetStr.empty())
+    return false;
 
   // Default variable argument is false.
   bool IsVari = false;
-  // The set of arguments' date types.
-  std::vector<Type *> ParamTypes;
+  // The arguments' date type strings.
+  SmallVector<StringRef, 8> ParaTyStrs;
   if (!Paras.empty()) {
-    SmallVector<StringRef, 128> ParaVec;
+    SmallVector<StringRef, 8> ParaVec;
     Paras.split(ParaVec, ',');
-    for (SmallVector<StringRef, 128>::iterator I = ParaVec.begin(),
-                                               E = ParaVec.end();
-         I != E; ++I) {
-      auto ParaStr = (*I).trim();
+    for (StringRef Para : ParaVec) {
+      StringRef ParaStr = Para.trim();
       // Skip void argument.
       if (ParaStr.lower() == "void")
         continue;
@@ -108,13 +144,12 @@ bool FunctionFilter::parsePrototypeStr(StringRef &InProt,
         IsVari = true;
         continue;
       }
-
-      ParamTypes.push_back(getPrimitiveDataType(ParaStr));
+      ParaTyStrs.push_back(ParaStr);
     }
   }
 
-  // Created function type.
-  FunctionType *FnTy = FunctionType::get(RetTy, ParamTypes, IsVari);
+  // Get the function type.
+  FunctionType *FnTy = getFunctionType(RetStr, ParaTyStrs, IsVari);
   assert(FnTy != nullptr && "Failed to construct function type!");
 
   if (OutProt.SymName != nullptr)
@@ -147,20 +182,79 @@ FunctionFilter::getOrCreateFunctionByPrototype(FunctionFilter::FuncInfo &Prot) {
   return Func;
 }
 
+FunctionFilter::FuncInfoList &
+FunctionFilter::getFuncInfoList(FunctionFilter::FilterType FT) {
+  if (FT == FILTER_INCLUDE)
+    return IncludedFunctions;
+  assert(FT == FILTER_EXCLUDE && "Unsupported filter type specified");
+  return ExcludedFunctions;
+}
+
+/// Add function specification FPT to list L. Return false if a function with
+/// the same symbol name is in the list.
+bool FunctionFilter::addFuncInfo(FuncInfoList &L, FuncInfo *FPT) {
+  if (!L.SymbolIndex.insert(std::make_pair(FPT->getSymName(),
+                                           L.Functions.size()))
+           .second)
+    return false;
+  L.Functions.push_back(FPT);
+  return true;
+}
+
+/// If the symbol name of FPT is a glob pattern or a regular expression
+/// enclosed in slashes, add it as a pattern to list L and return true.
+bool FunctionFilter::addFuncPattern(FuncInfoList &L, FuncInfo &FPT) {
+  StringRef Sym = FPT.getSymName();
+  FuncPattern Pattern;
+  if (Sym.size() > 2 && Sym.startswith("/") && Sym.endswith("/")) {
+    auto RE = std::make_unique<Regex>(
+        ("^(" + Sym.drop_front().drop_back() + ")$").str());
+    std::string Error;
+    if (!RE->isValid(Error)) {
+      dbgs() << "\nWarning: Ignoring invalid function filter pattern " << Sym
+             << " : " << Error << "\n";
+      return true;
+    }
+    Pattern.RE = std::move(RE);
+  } else if (Sym.find_first_of("*?[") != StringRef::npos) {
+    Expected<GlobPattern> Glob = GlobPattern::create(Sym);
+    if (!Glob) {
+      dbgs() << "\nWarning: Ignoring invalid function filter pattern " << Sym
+             << " : " << toString(Glob.takeError()) << "\n";
+      return true;
+    }
+    Pattern.Glob = std::move(*Glob);
+  } else
+    return false;
+
+  Pattern.Text = Sym.str();
+  Pattern.FuncType = FPT.FuncType;
+  L.Patterns.push_back(std::move(Pattern));
+  return true;
+}
+
 /// Add a new function with given prototype to excluded function list.
 void FunctionFilter::addExcludedFunction(StringRef &PrototypeStr) {
   FunctionFilter::FuncInfo *FPT = new FunctionFilter::FuncInfo();
-  assert(parsePrototypeStr(PrototypeStr, *FPT) &&
-         "Invalid function prototype string!");
+  bool Parsed = parsePrototypeStr(PrototypeStr, *FPT);
+  assert(Parsed && "Invalid function prototype string!");
+  (void)Parsed;
+  if (addFuncPattern(ExcludedFunctions, *FPT)) {
+    delete FPT;
+    return;
+  }
+
   Function *Funct = getOrCreateFunctionByPrototype(*FPT);
   FPT->StartIdx = 0;
   FPT->Func = Funct;
-  ExcludedFunctionVector.push_back(FPT);
+  if (!addFuncInfo(ExcludedFunctions, FPT)) {
+    delete FPT;
+    return;
+  }
 
   StringRef Sym = FPT->getSymName();
   // Ensure that this function symbol is not in included list.
-  if (IncludedFunctionVector.size() > 0 &&
-      findFuncInfoBySymbol(Sym, FILTER_INCLUDE) != nullptr) {
+  if (IncludedFunctions.SymbolIndex.count(Sym)) {
     eraseFunctionBySymbol(Sym, FILTER_INCLUDE);
     dbgs() << "\nWarning: " << Sym << " is both in tables"
            << " exclude-functions and include-functions, it will not be"
@@ -171,89 +265,107 @@ void FunctionFilter::addExcludedFunction(StringRef &PrototypeStr) {
 /// Add a new function with given prototype to included function list.
 void FunctionFilter::addIncludedFunction(StringRef &PrototypeStr) {
   FunctionFilter::FuncInfo *FPT = new FunctionFilter::FuncInfo();
-  assert(parsePrototypeStr(PrototypeStr, *FPT) &&
-         "Invalid function prototype string!");
+  bool Parsed = parsePrototypeStr(PrototypeStr, *FPT);
+  assert(Parsed && "Invalid function prototype string!");
+  (void)Parsed;
+  if (addFuncPattern(IncludedFunctions, *FPT)) {
+    delete FPT;
+    return;
+  }
+
   StringRef Sym = FPT->getSymName();
   // Check if this function symbol is in the excluded set. Flag and error
   // otherwise.
-  if (ExcludedFunctionVector.size() > 0 &&
-      findFuncInfoBySymbol(Sym, FILTER_EXCLUDE) != nullptr) {
+  if (ExcludedFunctions.SymbolIndex.count(Sym)) {
     dbgs() << "\n***** Warning: Found " << Sym << " both in "
            << " exclude-functions and include-functions. Considering it to be "
               "an excluded function\n";
-
+    delete FPT;
     return;
   }
 
   FPT->StartIdx = 0;
   FPT->Func = nullptr;
-  IncludedFunctionVector.push_back(FPT);
+  if (!addFuncInfo(IncludedFunctions, FPT))
+    delete FPT;
 }
 
-/// Find function with symbol name in specified list type.
+/// Find function with symbol name in specified list type. A function matching
+/// a pattern is added to the list, so that it is found by symbol name and
+/// start index from then on. As with functions specified by name, a function
+/// both excluded and included is excluded.
 FunctionFilter::FuncInfo *
 FunctionFilter::findFuncInfoBySymbol(StringRef &Sym,
                                      FunctionFilter::FilterType FT) {
-  FuncInfoVector FunctionVec;
-  if (FT == FILTER_INCLUDE)
-    FunctionVec = IncludedFunctionVector;
-  else if (FT == FILTER_EXCLUDE)
-    FunctionVec = ExcludedFunctionVector;
-  else
-    assert(false && "Unsupported filter type specified");
-
-  for (auto F : FunctionVec) {
-    if (F->getSymName() == Sym)
-      return F;
+  FuncInfoList &L = getFuncInfoList(FT);
+  auto I = L.SymbolIndex.find(Sym);
+  if (I != L.SymbolIndex.end())
+    return L.Functions[I->second];
+
+  for (FuncPattern &Pattern : L.Patterns) {
+    if (!Pattern.match(Sym))
+      continue;
+    Pattern.Matched = true;
+    if (FT == FILTER_EXCLUDE && IncludedFunctions.SymbolIndex.count(Sym)) {
+      eraseFunctionBySymbol(Sym, FILTER_INCLUDE);
+      dbgs() << "\nWarning: " << Sym << " is both in tables"
+             << " exclude-functions and include-functions, it will not be"
+             << " raised!\n";
+    } else if (FT == FILTER_INCLUDE &&
+               (ExcludedFunctions.SymbolIndex.count(Sym) ||
+                any_of(ExcludedFunctions.Patterns,
+                       [Sym](const FuncPattern &P) { return P.match(Sym); }))) {
+      dbgs() << "\n***** Warning: Found " << Sym << " both in "
+             << " exclude-functions and include-functions. Considering it to "
+                "be an excluded function\n";
+      return nullptr;
+    }
+    FunctionFilter::FuncInfo *FPT = new FunctionFilter::FuncInfo();
+    FPT->SymName = new std::string(Sym.str());
+    FPT->FuncType = Pattern.FuncType;
+    FPT->StartIdx = 0;
+    FPT->Func =
+        (FT == FILTER_EXCLUDE) ? getOrCreateFunctionByPrototype(*FPT) : nullptr;
+    addFuncInfo(L, FPT);
+    return FPT;
   }
 
   return nullptr;
 }
 
+/// Record the start index of the function of FI in specified list type.
+void FunctionFilter::setStartIndex(FunctionFilter::FuncInfo &FI,
+                                   uint64_t StartIndex,
+                                   FunctionFilter::FilterType FT) {
+  FI.StartIdx = StartIndex;
+  getFuncInfoList(FT).StartIndex[StartIndex] = &FI;
+}
+
 /// Find function with start index in the specified list type.
 Function *FunctionFilter::findFunctionByIndex(uint64_t StartIndex,
                                               FunctionFilter::FilterType FT) {
-  FuncInfoVector *FuncVec = nullptr;
-  if (FT == FILTER_INCLUDE)
-    FuncVec = &IncludedFunctionVector;
-  else if (FT == FILTER_EXCLUDE)
-    FuncVec = &ExcludedFunctionVector;
-  else
-    assert(false && "Unsupported filter type specified");
-
-  assert(FuncVec != nullptr && "Unexpected null function vector");
-
-  for (auto F : *FuncVec) {
-    if (F->StartIdx == StartIndex)
-      return F->Func;
-  }
-
-  return nullptr;
+  FuncInfoList &L = getFuncInfoList(FT);
+  auto I = L.StartIndex.find(StartIndex);
+  if (I == L.StartIndex.end())
+    return nullptr;
+  return I->second->Func;
 }
 
 /// Erase a function information from specified list type by symbol name.
 void FunctionFilter::eraseFunctionBySymbol(StringRef &Sym,
                                            FunctionFilter::FilterType FT) {
-  FuncInfoVector *FuncVec;
-  if (FT == FILTER_INCLUDE)
-    FuncVec = &IncludedFunctionVector;
-  else if (FT == FILTER_EXCLUDE)
-    FuncVec = &ExcludedFunctionVector;
-  else
-    assert(false && "Unsupported filter type specified");
-
-  assert(FuncVec != nullptr && "Unexpected null function vector");
-
-  for (FunctionFilter::FuncInfoVector::iterator I = FuncVec->begin(),
-                                                E = FuncVec->end();
-       I != E; ++I) {
-    auto EM = *I;
-    if (EM != nullptr && EM->getSymName() == Sym) {
-      FuncVec->erase(I);
-      delete EM;
-      return;
-    }
-  }
+  FuncInfoList &L = getFuncInfoList(FT);
+  auto I = L.SymbolIndex.find(Sym);
+  if (I == L.SymbolIndex.end())
+    return;
+
+  FunctionFilter::FuncInfo *EM = L.Functions[I->second];
+  L.Functions[I->second] = nullptr;
+  L.SymbolIndex.erase(I);
+  auto SI = L.StartIndex.find(EM->StartIdx);
+  if (SI != L.StartIndex.end() && SI->second == EM)
+    L.StartIndex.erase(SI);
+  delete EM;
 }
 
 /// Read the function symbol set from the configuration file of filter
@@ -328,31 +440,31 @@ bool FunctionFilter::readFilterFunctionConfigFile(
 
 // Test if the list of specified type is empty
 bool FunctionFilter::isFilterSetEmpty(FilterType FT) {
-  FuncInfoVector FunctionSet;
-  if (FT == FILTER_INCLUDE)
-    return IncludedFunctionVector.empty();
-  else if (FT == FILTER_EXCLUDE)
-    return ExcludedFunctionVector.empty();
-
-  llvm_unreachable_internal("Unexpected function filter type specified");
+  FuncInfoList &L = getFuncInfoList(FT);
+  return L.SymbolIndex.empty() &&
+         none_of(L.Patterns,
+                 [](const FuncPattern &Pattern) { return !Pattern.Matched; });
 }
 
 /// Dump the list of specified list; dump both include and exclude lists if no
-/// argument is specified.
+/// argument is specified. Patterns that matched a function are not dumped.
 void FunctionFilter::dump(FilterType FT) {
+  auto DumpList = [](const FuncInfoList &L) {
+    for (const FunctionFilter::FuncInfo *FFI : L.Functions)
+      if (FFI != nullptr)
+        dbgs() << FFI->getSymName() << " ";
+    for (const FuncPattern &Pattern : L.Patterns)
+      if (!Pattern.Matched)
+        dbgs() << Pattern.Text << " ";
+  };
+
   if ((FT == FILTER_NONE) || (FT == FILTER_INCLUDE)) {
     dbgs() << "Included functions\n";
-    std::for_each(IncludedFunctionVector.begin(), IncludedFunctionVector.end(),
-                  [](const FunctionFilter::FuncInfo *FFI) {
-                    dbgs() << FFI->getSymName() << " ";
-                  });
+    DumpList(IncludedFunctions);
   }
 
   if ((FT == FILTER_NONE) || (FT == FILTER_EXCLUDE)) {
     dbgs() << "Excluded functions\n";
-    std::for_each(ExcludedFunctionVector.begin(), ExcludedFunctionVector.end(),
-                  [](const FunctionFilter::FuncInfo *FFI) {
-                    dbgs() << FFI->getSymName() << " ";
-                  });
+    DumpList(ExcludedFunctions);
   }
 }
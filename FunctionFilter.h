@@ -15,14 +15,22 @@
 #ifndef LLVM_TOOLS_LLVM_MCTOLL_FUNCTIONFILTER_H
 #define LLVM_TOOLS_LLVM_MCTOLL_FUNCTIONFILTER_H
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Support/GlobPattern.h"
+#include "llvm/Support/Regex.h"
 
 using namespace llvm;
 
 /// Class encapsulating lists of function specifications to be included and
-/// excluded along with methods to maintain and query the lists.
+/// excluded along with methods to maintain and query the lists. The symbol
+/// name of a specification may be a glob pattern, such as "hot_*", or a
+/// regular expression enclosed in slashes, such as "/^(get|set)_.+/", that
+/// specifies all functions with matching names.
 class FunctionFilter {
 public:
   /// Filter types supported
@@ -67,6 +75,9 @@ public:
   /// Find function with symbol name in specified list type.
   FunctionFilter::FuncInfo *findFuncInfoBySymbol(StringRef &Sym,
                                                  FunctionFilter::FilterType FT);
+  /// Record the start index of the function of FI in specified list type.
+  void setStartIndex(FuncInfo &FI, uint64_t StartIndex,
+                     FunctionFilter::FilterType FT);
   /// Find function with start index in the specified list type.
   Function *findFunctionByIndex(uint64_t StartIndex,
                                 FunctionFilter::FilterType FT);
@@ -78,20 +89,64 @@ public:
   void eraseFunctionBySymbol(StringRef &Sym, FunctionFilter::FilterType FT);
   /// Get the data type corresponding to type string.
   Type *getPrimitiveDataType(const StringRef &TypeStr);
+  /// Get the function type with the return and parameter types corresponding
+  /// to the type strings. Function types are constructed once per distinct
+  /// signature.
+  FunctionType *getFunctionType(StringRef RetTyStr,
+                                ArrayRef<StringRef> ParamTyStrs,
+                                bool IsVarArg);
   /// Read user-specified include and exclude functions from file
   bool readFilterFunctionConfigFile(std::string &FunctionFilterFilename);
-  /// Test if the list of specified list is empty.
+  /// Test if the list of specified list is empty, i.e., has no function
+  /// specification left and no pattern that did not match a function yet.
   bool isFilterSetEmpty(FilterType);
   /// Dump the list of specified list; dump both include and exclude lists if no
   /// argument is specified.
   void dump(FilterType FT = FILTER_NONE);
 
 private:
-  /// Excluded function vector.
-  FuncInfoVector ExcludedFunctionVector;
-  /// Included function vector.
-  FuncInfoVector IncludedFunctionVector;
+  /// Symbol name pattern of function specifications.
+  struct FuncPattern {
+    std::string Text;
+    Optional<GlobPattern> Glob;
+    std::unique_ptr<Regex> RE;
+    FunctionType *FuncType = nullptr;
+    /// Whether any symbol matched the pattern.
+    bool Matched = false;
+
+    bool match(StringRef Sym) const {
+      return Glob ? Glob->match(Sym) : RE->match(Sym);
+    }
+  };
+
+  /// List of function specifications of a filter type, indexed by symbol
+  /// name and function start index.
+  struct FuncInfoList {
+    /// Function specifications in the order specified. Erased ones are null.
+    FuncInfoVector Functions;
+    /// Position of function specifications in Functions by symbol name.
+    StringMap<size_t> SymbolIndex;
+    /// Function specifications by start index.
+    DenseMap<uint64_t, FuncInfo *> StartIndex;
+    /// Patterns in the order specified.
+    std::vector<FuncPattern> Patterns;
+  };
+
+  FuncInfoList &getFuncInfoList(FilterType FT);
+  /// Add function specification FPT to list L. Return false if a function
+  /// with the same symbol name is in the list.
+  bool addFuncInfo(FuncInfoList &L, FuncInfo *FPT);
+  /// If the symbol name of FPT is a pattern, add it as such to list L and
+  /// return true.
+  bool addFuncPattern(FuncInfoList &L, FuncInfo &FPT);
+
+  /// Excluded functions.
+  FuncInfoList ExcludedFunctions;
+  /// Included functions.
+  FuncInfoList IncludedFunctions;
   // Module associated with this class
   Module &M;
+  /// Function types constructed by getFunctionType(), keyed by signature.
+  StringMap<FunctionType *> FunctionTypes;
 };
 #endif // LLVM_TOOLS_LLVM_MCTOLL_FUNCTIONFILTER_H
@@ -82,6 +82,15 @@ public:
 
   uint64_t getMCInstIndex(const MachineInstr &MI) const;
 
+  // Free the MCInsts and the CFG bookkeeping of the function once it is
+  // raised. Only the start and end offsets of the function remain valid.
+  void releaseMCInsts() {
+    mcInstMap.clear();
+    targetIndices.clear();
+    mcInstToMBBNum.clear();
+    MBBNumToMCInstTargetsMap.clear();
+  }
+
 private:
   // NOTE: The following data structures are implemented to record instruction
   //       targets. Separate data structures are used instead of aggregating the
@@ -120,6 +120,7 @@ static const Target *GetTarget(const MachOObjectFile *MachOObj,
   }
 
   // Get the target specific parser.
+  initializeTarget(TT.getArch());
   std::string Error;
   const Target *TheTarget = TargetRegistry::lookupTarget(TripleName, Error);
   if (TheTarget && ThumbTripleName.empty())
@@ -36,13 +36,33 @@ MachineInstructionRaiser *MachineFunctionRaiser::getMachineInstrRaiser() {
 }
 
 Function *MachineFunctionRaiser::getRaisedFunction() {
+  if (machineInstRaiser == nullptr)
+    return raisedFunction;
   return machineInstRaiser->getRaisedFunction();
 }
 
 void MachineFunctionRaiser::setRaisedFunction(Function *F) {
+  if (machineInstRaiser == nullptr) {
+    raisedFunction = F;
+    return;
+  }
   return machineInstRaiser->setRaisedFunction(F);
 }
 
+void MachineFunctionRaiser::releaseMachineState() {
+  if (machineInstRaiser == nullptr)
+    return;
+
+  raisedFunction = machineInstRaiser->getRaisedFunction();
+  delete machineInstRaiser;
+  machineInstRaiser = nullptr;
+  mcInstRaiser->releaseMCInsts();
+  std::vector<IndexedData32>().swap(dataBlobVector);
+  // MF is owned by MachineModuleInfo and is associated with the placeholder
+  // function it was created for.
+  MF.getMMI().deleteMachineFunctionFor(MF.getFunction());
+}
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -53,7 +73,12 @@ extern "C" {
 }
 #endif
 
-void ModuleRaiser::InitializeAllModuleRaisers() {
-#define MODULE_RAISER(TargetName) Initialize##TargetName##ModuleRaiser();
+bool ModuleRaiser::InitializeModuleRaisers(StringRef TargetName) {
+#define MODULE_RAISER(Name)                                                    \
+  if (TargetName == #Name) {                                                   \
+    Initialize##Name##ModuleRaiser();                                          \
+    return true;                                                               \
+  }
 #include "Raisers.def"
+  return false;
 }
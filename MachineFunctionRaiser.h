@@ -29,7 +29,8 @@ class MachineFunctionRaiser {
 public:
   MachineFunctionRaiser(Module &M, MachineFunction &MF, const ModuleRaiser *MR,
                         uint64_t Start, uint64_t End)
-      : MF(MF), M(M), machineInstRaiser(nullptr), MR(MR) {
+      : MF(MF), M(M), machineInstRaiser(nullptr), raisedFunction(nullptr),
+        MR(MR) {
 
     mcInstRaiser = new MCInstRaiser(Start, End);
 
@@ -37,7 +38,11 @@ public:
     MF.getProperties().reset(MachineFunctionProperties::Property::IsSSA);
   };
 
-  virtual ~MachineFunctionRaiser() { delete mcInstRaiser; }
+  // The MachineFunction is owned by MachineModuleInfo and is not freed here.
+  virtual ~MachineFunctionRaiser() {
+    delete machineInstRaiser;
+    delete mcInstRaiser;
+  }
 
   bool runRaiserPasses();
 
@@ -62,6 +67,12 @@ public:
   // Cleanup orphaned empty basic blocks from raised function
   void cleanupRaisedFunction();
 
+  // Free the MachineFunction, the machine instruction raiser and the MCInsts
+  // of the function once it is raised. Only the raised function and the
+  // function bounds remain accessible; the MachineFunction and machine
+  // instruction raiser must not be used afterwards.
+  void releaseMachineState();
+
 private:
   MachineFunction &MF;
   Module &M;
@@ -69,6 +80,8 @@ private:
   // Data members built and used by this class
   MCInstRaiser *mcInstRaiser;
   MachineInstructionRaiser *machineInstRaiser;
+  // The raised function, once machineInstRaiser is released.
+  Function *raisedFunction;
   // A vector of data blobs found in the instruction stream
   // of this function. A data blob is a sequence of data bytes.
   // Multiple such data blobs may be found while disassembling
@@ -46,7 +46,10 @@ public:
   MachineInstructionRaiser(MachineFunction &machFunc, const ModuleRaiser *mr,
                            MCInstRaiser *mcir = nullptr)
       : MF(machFunc), raisedFunction(nullptr), mcInstRaiser(mcir), MR(mr) {}
-  virtual ~MachineInstructionRaiser(){};
+  virtual ~MachineInstructionRaiser() {
+    for (ControlTransferInfo *CTI : CTInfo)
+      delete CTI;
+  };
 
   virtual bool raise() { return true; };
   virtual FunctionType *getRaisedFunctionPrototype() = 0;
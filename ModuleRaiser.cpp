@@ -8,10 +8,49 @@
 //===----------------------------------------------------------------------===//
 
 #include "ModuleRaiser.h"
+#include "BranchProfile.h"
+#include "ExternalFunctions.h"
+#include "InstMetadata.h"
 #include "MachineFunctionRaiser.h"
 #include "MachineInstructionRaiser.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SCCIterator.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/Analysis/CaptureTracking.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/DebugInfoMetadata.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/Object/ELFObjectFile.h"
+#include "llvm/Passes/PassBuilder.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Transforms/AggressiveInstCombine/AggressiveInstCombine.h"
+#include "llvm/Transforms/InstCombine/InstCombine.h"
+#include "llvm/Transforms/Scalar/ADCE.h"
+#include "llvm/Transforms/Scalar/DCE.h"
+#include "llvm/Transforms/Scalar/EarlyCSE.h"
+#include "llvm/Transforms/Scalar/GVN.h"
+#include "llvm/Transforms/Scalar/SROA.h"
+#include "llvm/Transforms/Scalar/SimplifyCFG.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/Transforms/Utils/BuildLibCalls.h"
+#include "llvm/Transforms/Utils/Mem2Reg.h"
+#include "llvm/Transforms/Utils/UnifyFunctionExitNodes.h"
+#include <chrono>
 #define DEBUG_TYPE "mctoll"
 
 Function *ModuleRaiser::getRaisedFunctionAt(uint64_t Index) const {
@@ -72,7 +111,76 @@ Function *ModuleRaiser::getCalledFunctionUsingTextReloc(uint64_t Loc,
   return nullptr;
 }
 
-bool ModuleRaiser::runMachineFunctionPasses() {
+namespace {
+// A node of the direct call graph of the machine functions being raised. The
+// root node, without a machine function, calls all functions.
+struct MachineCallGraphNode {
+  MachineFunctionRaiser *MFR = nullptr;
+  SmallVector<MachineCallGraphNode *, 8> Callees;
+};
+} // namespace
+
+namespace llvm {
+template <> struct GraphTraits<MachineCallGraphNode *> {
+  using NodeRef = MachineCallGraphNode *;
+  using ChildIteratorType = SmallVectorImpl<MachineCallGraphNode *>::iterator;
+
+  static NodeRef getEntryNode(NodeRef N) { return N; }
+  static ChildIteratorType child_begin(NodeRef N) {
+    return N->Callees.begin();
+  }
+  static ChildIteratorType child_end(NodeRef N) { return N->Callees.end(); }
+};
+} // namespace llvm
+
+// Build the direct call graph of the functions raised by MFRs from the
+// targets of their calls and of their conditional or unconditional jumps out
+// of the function, i.e., tail calls. Nodes[0] is the root node.
+static void
+buildMachineCallGraph(const std::vector<MachineFunctionRaiser *> &MFRs,
+                      const MCInstrAnalysis *MIA,
+                      std::vector<MachineCallGraphNode> &Nodes) {
+  Nodes.resize(MFRs.size() + 1);
+  DenseMap<uint64_t, MachineCallGraphNode *> NodeAt;
+  for (size_t I = 0, E = MFRs.size(); I != E; ++I) {
+    MachineCallGraphNode *N = &Nodes[I + 1];
+    N->MFR = MFRs[I];
+    NodeAt[MFRs[I]->getMCInstRaiser()->getFuncStart()] = N;
+    Nodes[0].Callees.push_back(N);
+  }
+
+  for (MachineCallGraphNode &N : drop_begin(Nodes, 1)) {
+    MCInstRaiser *MCIR = N.MFR->getMCInstRaiser();
+    SmallPtrSet<MachineCallGraphNode *, 8> Callees;
+    for (auto I = MCIR->const_mcinstr_begin(), E = MCIR->const_mcinstr_end();
+         I != E; ++I) {
+      if (!I->second.isMCInst())
+        continue;
+      MCInst Inst = I->second.getMCInst();
+      bool IsCall = MIA->isCall(Inst);
+      if (!IsCall && !MIA->isBranch(Inst))
+        continue;
+      uint64_t Target;
+      if (!MIA->evaluateBranch(Inst, I->first,
+                               MCIR->getMCInstSize(I->first), Target))
+        continue;
+      if (!IsCall && MCIR->isMCInstInRange(Target))
+        continue;
+      auto Callee = NodeAt.find(Target);
+      if (Callee != NodeAt.end() && Callees.insert(Callee->second).second)
+        N.Callees.push_back(Callee->second);
+    }
+  }
+}
+
+ModuleRaiser::~ModuleRaiser() {
+  for (MachineFunctionRaiser *MFR : mfRaiserVector)
+    delete MFR;
+  if (FFT != nullptr)
+    delete FFT;
+}
+
+bool ModuleRaiser::runMachineFunctionPasses(bool ReleaseMachineState) {
   bool Success = true;
 
   for (auto MFR : mfRaiserVector) {
@@ -82,48 +190,126 @@ bool ModuleRaiser::runMachineFunctionPasses() {
     LLVM_DEBUG(MFR->getMCInstRaiser()->dump());
   }
 
-  // For each of the functions, run passes to set up for instruction raising.
-  for (auto MFR : mfRaiserVector) {
-    // 1. Build CFG
-    MCInstRaiser *MCIR = MFR->getMCInstRaiser();
-    // Populates the MachineFunction with CFG.
-    MCIR->buildCFG(MFR->getMachineFunction(), MIA, MII);
-  }
-
   // Construct function prototypes for each of the MachineFunctions.
   // Knowing the function prototypes prior to raising the instructions
   // facilitates raising of call instructions whose targets are within
-  // the current module.
-  // Iterate the MachineFunctions twice to determine the prototypes of functions
-  // that might call those whose prototypes were not yet constructed.
-
-  // why raise function twice time here?
-  bool AllPrototypesConstructed;
-  const int IterCount = 2;
-  for (int i = 0; i < IterCount; i++) {
-    AllPrototypesConstructed = true;
-    for (auto MFR : mfRaiserVector) {
-      LLVM_DEBUG(dbgs() << "Build Prototype for : "
-                        << MFR->getMachineFunction().getName().data() << "\n");
-      Function *RF = MFR->getRaisedFunction();
-      if (RF == nullptr) {
-        FunctionType *FT =
-            MFR->getMachineInstrRaiser()->getRaisedFunctionPrototype();
-        AllPrototypesConstructed |= (FT != nullptr);
+  // the current module. Walk the SCCs of the direct call graph bottom-up so
+  // that the prototypes of callees are known when those of their callers are
+  // constructed. Within an SCC, retry the functions whose prototype could not
+  // be constructed as long as some other one could.
+  std::vector<MachineCallGraphNode> CallGraph;
+  buildMachineCallGraph(mfRaiserVector, MIA, CallGraph);
+
+  // With the raised function cache enabled, a function that is not part of a
+  // call cycle is taken from the cache if its key is found there, once the
+  // prototypes of its callees are known. Neither its CFG nor its prototype
+  // are built and it is not raised again.
+  std::string CacheContext;
+  DenseMap<uint64_t, StringRef> FuncNameAt;
+  DenseMap<MachineFunctionRaiser *, std::string> CacheKeys;
+  SmallPtrSet<MachineFunctionRaiser *, 16> CachedMFRs;
+  if (FunctionCache) {
+    CacheContext = getRaisedFunctionCacheContext();
+    for (auto MFR : mfRaiserVector)
+      FuncNameAt[MFR->getMCInstRaiser()->getFuncStart()] =
+          MFR->getMachineFunction().getName();
+  }
+
+  for (scc_iterator<MachineCallGraphNode *> SCCI = scc_begin(&CallGraph[0]);
+       !SCCI.isAtEnd(); ++SCCI) {
+    const std::vector<MachineCallGraphNode *> &SCC = *SCCI;
+    if (FunctionCache && SCC.size() == 1 && SCC[0]->MFR != nullptr &&
+        !SCCI.hasCycle()) {
+      MachineFunctionRaiser *MFR = SCC[0]->MFR;
+      std::string Key =
+          getRaisedFunctionCacheKey(MFR, CacheContext, FuncNameAt);
+      if (loadCachedRaisedFunction(MFR, Key)) {
+        LLVM_DEBUG(dbgs() << "Reused cached raised function "
+                          << MFR->getRaisedFunction()->getName() << "\n");
+        CachedMFRs.insert(MFR);
+        continue;
       }
+      CacheKeys[MFR] = std::move(Key);
     }
-    LLVM_DEBUG(dbgs() << "Raised Function Prototypes: \n");
-    LLVM_DEBUG({
-      for (auto MFR : mfRaiserVector) {
-        MFR->getRaisedFunction()->dump();
+
+    // Populate the MachineFunctions of the SCC with their CFGs.
+    for (MachineCallGraphNode *N : SCC)
+      if (N->MFR != nullptr)
+        N->MFR->getMCInstRaiser()->buildCFG(N->MFR->getMachineFunction(), MIA,
+                                            MII);
+
+    bool Progress = true;
+    while (Progress) {
+      Progress = false;
+      for (MachineCallGraphNode *N : SCC) {
+        // Skip the root node and functions with a prototype.
+        if (N->MFR == nullptr || N->MFR->getRaisedFunction() != nullptr)
+          continue;
+        LLVM_DEBUG(dbgs() << "Build Prototype for : "
+                          << N->MFR->getMachineFunction().getName().data()
+                          << "\n");
+        FunctionType *FT =
+            N->MFR->getMachineInstrRaiser()->getRaisedFunctionPrototype();
+        Progress |= (FT != nullptr);
       }
-    });
+    }
   }
-  assert(AllPrototypesConstructed && "Failed to construct all prototypes");
+  // The prototype of a function may depend on functions it reaches other
+  // than by direct calls, e.g., through function pointers. Retry those whose
+  // prototype could not be constructed once all others are known.
+  for (auto MFR : mfRaiserVector) {
+    if (MFR->getRaisedFunction() != nullptr)
+      continue;
+    LLVM_DEBUG(dbgs() << "Retry Prototype for : "
+                      << MFR->getMachineFunction().getName().data() << "\n");
+    MFR->getMachineInstrRaiser()->getRaisedFunctionPrototype();
+  }
+  LLVM_DEBUG(dbgs() << "Raised Function Prototypes: \n");
+  LLVM_DEBUG({
+    for (auto MFR : mfRaiserVector)
+      if (MFR->getRaisedFunction() != nullptr)
+        MFR->getRaisedFunction()->dump();
+  });
+  assert(all_of(mfRaiserVector,
+                [](MachineFunctionRaiser *MFR) {
+                  return MFR->getRaisedFunction() != nullptr;
+                }) &&
+         "Failed to construct all prototypes");
   // Run instruction raiser passes.
   
-  for (auto MFR : mfRaiserVector)
-    Success |= MFR->runRaiserPasses();
+  // Functions are raised with the prototypes of all functions known, so the
+  // machine-level state of a raised function is not used by those raised
+  // after it. Return type changes are recorded while raising and applied
+  // once all functions are raised.
+  for (auto MFR : mfRaiserVector) {
+    if (CachedMFRs.count(MFR) == 0) {
+      bool Raised = MFR->runRaiserPasses();
+      Success |= Raised;
+      // Do not cache functions that failed to raise.
+      if (!Raised)
+        CacheKeys.erase(MFR);
+    }
+    if (ReleaseMachineState)
+      MFR->releaseMachineState();
+  }
+  applyReturnTypeChanges();
+
+  // Cache the functions raised with their final prototypes.
+  if (FunctionCache) {
+    unsigned NumNotStored = 0;
+    for (auto MFR : mfRaiserVector) {
+      auto K = CacheKeys.find(MFR);
+      if (K != CacheKeys.end() &&
+          !FunctionCache->store(K->second, *MFR->getRaisedFunction()))
+        ++NumNotStored;
+    }
+    if (NumNotStored != 0)
+      errs() << "Unable to record " << NumNotStored
+             << " raised function(s) in the raised function cache\n";
+    LLVM_DEBUG(dbgs() << "Reused " << CachedMFRs.size() << " of "
+                      << mfRaiserVector.size()
+                      << " raised functions from the cache\n");
+  }
 
   return Success;
 }
@@ -185,127 +371,1499 @@ int64_t ModuleRaiser::getTextSectionAddress() const {
   llvm_unreachable("Failed to locate text section.");
 }
 
-// Change return type of TargetFunc and update the change in module and
-// MachineFunctionRaiser of TargetFunc. The new function is the same in every
-// respect except with specified return type. Return true to indicate a change;
-// false otherwise.
+// Record the change of the return type of TargetFunc to NewRetTy. The
+// function is recreated with the new return type by applyReturnTypeChanges()
+// once all functions are raised. Return true to indicate a change; false
+// otherwise.
 bool ModuleRaiser::changeRaisedFunctionReturnType(Function *TargetFunc,
                                                   Type *NewRetTy) {
-  Type *TgtFuncRetTy = TargetFunc->getReturnType();
-  // Was the change affected?
-  bool Changed = false;
+  if (getRaisedFunctionReturnType(TargetFunc) == NewRetTy)
+    return false;
+  ReturnTypeChanges[TargetFunc] = NewRetTy;
+  return true;
+}
 
-  // Get the MachineFunction of TargetFunc
-  MachineFunctionRaiser *TargetFuncMFRaiser = nullptr;
-  for (auto MIR : mfRaiserVector) {
-    if (MIR->getRaisedFunction() == TargetFunc) {
-      TargetFuncMFRaiser = MIR;
-      break;
+Type *ModuleRaiser::getRaisedFunctionReturnType(Function *F) const {
+  auto C = ReturnTypeChanges.find(F);
+  if (C == ReturnTypeChanges.end())
+    return F->getReturnType();
+  return C->second;
+}
+
+// Return V converted to type Ty by a cast instruction inserted before
+// InsertBefore, if needed.
+static Value *castReturnValue(Value *V, Type *Ty, Instruction *InsertBefore) {
+  Type *SrcTy = V->getType();
+  if (SrcTy == Ty)
+    return V;
+  auto IsScalar = [](Type *T) {
+    return T->isIntOrPtrTy() || T->isFloatingPointTy();
+  };
+  if (!IsScalar(SrcTy) || !IsScalar(Ty) ||
+      (SrcTy->isPointerTy() && Ty->isFloatingPointTy()) ||
+      (SrcTy->isFloatingPointTy() && Ty->isPointerTy()))
+    return UndefValue::get(Ty);
+  return CastInst::Create(CastInst::getCastOpcode(V, false, Ty, false), V, Ty,
+                          "", InsertBefore);
+}
+
+// Add the calls of F to Calls. Calls raised while the return type of F was
+// being changed call a cast of F to the changed prototype.
+static void collectCallsOf(Function *F, SmallVectorImpl<CallInst *> &Calls) {
+  for (User *U : F->users()) {
+    if (auto *CE = dyn_cast<ConstantExpr>(U)) {
+      if (CE->getOpcode() == Instruction::BitCast)
+        for (User *CU : CE->users())
+          if (auto *CI = dyn_cast<CallInst>(CU))
+            if (CI->getCalledOperand() == CE)
+              Calls.push_back(CI);
+      continue;
     }
+    if (auto *CI = dyn_cast<CallInst>(U))
+      if (CI->getCalledFunction() == F)
+        Calls.push_back(CI);
   }
+}
 
-  assert(TargetFuncMFRaiser != nullptr &&
-         "Expect to find MachineFunction raiser for return type change");
+// Return the return instruction if CI is in tail position, i.e., it is
+// followed only by casts of its result and a return, possibly in a successor
+// block holding nothing else but PHIs, of its result or of no value.
+// Otherwise, return nullptr.
+static ReturnInst *getTailCallReturn(CallInst *CI) {
+  SmallPtrSet<Value *, 4> Results;
+  Results.insert(CI);
+  Instruction *I = CI->getNextNode();
+  for (; !I->isTerminator(); I = I->getNextNode()) {
+    auto *Cast = dyn_cast<CastInst>(I);
+    if (Cast == nullptr || !Results.count(Cast->getOperand(0)))
+      return nullptr;
+    Results.insert(Cast);
+  }
 
-  if (TgtFuncRetTy != NewRetTy) {
-    std::vector<Type *> ArgTypes;
-    for (const Argument &I : TargetFunc->args())
-      ArgTypes.push_back(I.getType());
+  BasicBlock *CallBB = CI->getParent();
+  if (auto *Br = dyn_cast<BranchInst>(I)) {
+    if (Br->isConditional())
+      return nullptr;
+    I = Br->getSuccessor(0)->getFirstNonPHI();
+  }
+  auto *Ret = dyn_cast<ReturnInst>(I);
+  if (Ret == nullptr)
+    return nullptr;
+
+  Value *RetVal = Ret->getReturnValue();
+  if (RetVal == nullptr)
+    return Ret;
+  if (auto *PN = dyn_cast<PHINode>(RetVal))
+    if (PN->getParent() == Ret->getParent() && Ret->getParent() != CallBB)
+      RetVal = PN->getIncomingValueForBlock(CallBB);
+  return Results.count(RetVal) ? Ret : nullptr;
+}
 
-    // Create function with new signature and clone the old body into it.
-    FunctionType *NewFT = FunctionType::get(NewRetTy, ArgTypes, false);
-    Function *NewF =
-        Function::Create(NewFT, TargetFunc->getLinkage(),
-                         TargetFunc->getAddressSpace(), TargetFunc->getName());
-    NewF->copyAttributesFrom(TargetFunc);
-    NewF->setSubprogram(TargetFunc->getSubprogram());
+bool ModuleRaiser::applyReturnTypeChanges() {
+  // A function that returns the result of a call in tail position returns
+  // the type of its callee. Propagate the recorded changes from callees to
+  // tail callers, so that the final return type of each function is known
+  // before any function is recreated. Calls are not marked tail yet, so tail
+  // position is determined from the instructions that follow them.
+  MapVector<Function *, Type *> NewRetTys;
+  SmallVector<Function *, 8> Worklist;
+  for (auto &C : ReturnTypeChanges) {
+    if (C.first->getReturnType() == C.second)
+      continue;
+    NewRetTys[C.first] = C.second;
+    Worklist.push_back(C.first);
+  }
+  ReturnTypeChanges.clear();
+  while (!Worklist.empty()) {
+    Function *F = Worklist.pop_back_val();
+    Type *NewRetTy = NewRetTys[F];
+    SmallVector<CallInst *, 8> Calls;
+    collectCallsOf(F, Calls);
+    for (CallInst *CI : Calls) {
+      if (getTailCallReturn(CI) == nullptr)
+        continue;
+      Function *Caller = CI->getFunction();
+      auto C = NewRetTys.find(Caller);
+      Type *CallerRetTy =
+          (C == NewRetTys.end()) ? Caller->getReturnType() : C->second;
+      if (CallerRetTy == NewRetTy)
+        continue;
+      NewRetTys[Caller] = NewRetTy;
+      Worklist.push_back(Caller);
+    }
+  }
+  if (NewRetTys.empty())
+    return false;
 
-    TargetFunc->getParent()->getFunctionList().insert(TargetFunc->getIterator(),
-                                                      NewF);
-    NewF->takeName(TargetFunc);
+  DenseMap<Function *, MachineFunctionRaiser *> RaiserOf;
+  for (auto MFR : mfRaiserVector)
+    RaiserOf[MFR->getRaisedFunction()] = MFR;
 
+  // Create each changed function with its new signature and move the old
+  // body into it.
+  MapVector<Function *, Function *> NewFuncs;
+  SmallPtrSet<Function *, 8> NewFuncSet;
+  for (auto &C : NewRetTys) {
+    Function *OldF = C.first;
+    std::vector<Type *> ArgTypes;
+    for (const Argument &I : OldF->args())
+      ArgTypes.push_back(I.getType());
+    FunctionType *NewFT = FunctionType::get(C.second, ArgTypes, false);
+    Function *NewF = Function::Create(NewFT, OldF->getLinkage(),
+                                      OldF->getAddressSpace(), "");
+    NewF->copyAttributesFrom(OldF);
+    NewF->setSubprogram(OldF->getSubprogram());
+    M->getFunctionList().insert(OldF->getIterator(), NewF);
+    NewF->takeName(OldF);
     NewF->getBasicBlockList().splice(NewF->begin(),
-                                     TargetFunc->getBasicBlockList());
-    // Loop over the argument list, transferring uses of the old arguments over
-    // to the new arguments, also transferring over the names as well.
-    for (Function::arg_iterator I = TargetFunc->arg_begin(),
-                                E = TargetFunc->arg_end(),
+                                     OldF->getBasicBlockList());
+    // Transfer the uses and names of the old arguments to the new ones.
+    for (Function::arg_iterator I = OldF->arg_begin(), E = OldF->arg_end(),
                                 I2 = NewF->arg_begin();
-         I != E; ++I) {
-      // Move the name and users over to the new version.
+         I != E; ++I, ++I2) {
       I->replaceAllUsesWith(&*I2);
       I2->takeName(&*I);
-      ++I2;
-    }
-    // Change the function type used in any of the users of this function to
-    // match that for NewF.
-    for (auto *U : TargetFunc->getFunction().users()) {
-      if (auto *C = dyn_cast<CallInst>(U)) {
-        CallInst *TgtFuncCall = const_cast<CallInst *>(C);
-        SmallVector<Instruction *, 8> TgtFuncCallsToDelete;
-        // If changing to a function type with void return type, the original
-        // call instruction's return value should have no uses. Remove its name
-        if (NewRetTy->isVoidTy()) {
-          if (!TgtFuncCall->uses().empty()) {
-            // If there are users, they are just pro-active cast
-            // instructions
-            for (auto *RetUsr : TgtFuncCall->users()) {
-              if (CastInst *CI = dyn_cast<CastInst>(RetUsr)) {
-                assert((CI->uses().empty()) &&
-                       "Unexpected uses of a void return value");
-                TgtFuncCallsToDelete.push_back(CI);
-              } else
-                assert(false && "Unhandled use of return value");
-            }
-          }
-          TgtFuncCall->setName("");
-        }
-        TgtFuncCall->mutateFunctionType(NewFT);
-        TgtFuncCall->setCalledFunction(NewF);
+    }
 
-        for (Instruction *I : TgtFuncCallsToDelete) {
-          I->eraseFromParent();
-        }
-        // If TgtFuncCall is a tail call, modify return instruction in the
-        // return block of the Function containing TgtFuncCall according to
-        // NewRetTy. Note that all functions have a single return block since
-        // UnifyFunctionExitNodes pass should have run on TgtFuncCallerFunc
-        // after its construction except the current function.
-        if (TgtFuncCall->isTailCall()) {
-          LLVMContext &Ctx(TargetFunc->getContext());
-          Function *TgtFuncCallerFunc = TgtFuncCall->getParent()->getParent();
-          for (BasicBlock &BB : *TgtFuncCallerFunc) {
-            if (auto RI = dyn_cast<ReturnInst>(BB.getTerminator())) {
-              Value *NewRetVal = (NewRetTy->isVoidTy()) ? nullptr : TgtFuncCall;
-              // If NewRetTy is void, NewRetVal is void else it is OrigCall
-              // create and insert a new return instruction returning NewRetVal
-              ReturnInst::Create(Ctx, NewRetVal, RI);
-              // delete original ret instruction.
-              RI->eraseFromParent();
-              // No further search for blocks with return needed since the pass
-              // UnifyFunctionExitNodes should have run on OrigCallFunc after
-              // its construction - unless the TgtFuncCallerFunc is the
-              // TargetFunc, in which case, the pass has not been run yet. Hence
-              // all return instructions need to be changed.
-              if (TgtFuncCallerFunc != TargetFunc)
-                break;
-            }
-          }
-          // Change the return type of TgtFuncCallerFunc since this is a tail
-          // call if it is not changed in the current modification.
-          // NOTE: This is a recursive call. Since the return type being changed
-          // i.e., NewRetTy, is the same for all the target functions, the
-          // recursive call will reach a  fix-point and will terminate.
-          changeRaisedFunctionReturnType(TgtFuncCallerFunc, NewRetTy);
+    auto R = RaiserOf.find(OldF);
+    assert(R != RaiserOf.end() &&
+           "Expect to find MachineFunction raiser for return type change");
+    R->second->setRaisedFunction(NewF);
+    auto PH = PlaceholderRaisedFunctionMap.find(OldF);
+    if (PH != PlaceholderRaisedFunctionMap.end()) {
+      Function *Placeholder = PH->second;
+      PlaceholderRaisedFunctionMap.erase(PH);
+      PlaceholderRaisedFunctionMap.insert(std::make_pair(NewF, Placeholder));
+    }
+    NewFuncs[OldF] = NewF;
+    NewFuncSet.insert(NewF);
+  }
+
+  // Rewrite each call of a changed function once. Uses of the return value
+  // are given the old type back, except by returns of changed functions,
+  // which are rewritten below.
+  for (auto &NF : NewFuncs) {
+    Function *OldF = NF.first;
+    Function *NewF = NF.second;
+    Type *NewRetTy = NewF->getReturnType();
+    SmallVector<CallInst *, 8> Calls;
+    collectCallsOf(OldF, Calls);
+
+    for (CallInst *CI : Calls) {
+      Type *OldRetTy = CI->getType();
+      SmallVector<Use *, 4> RetValUses;
+      SmallVector<Instruction *, 4> DeadCasts;
+      for (Use &U : CI->uses()) {
+        auto *UI = cast<Instruction>(U.getUser());
+        if (isa<ReturnInst>(UI) && NewFuncSet.count(UI->getFunction()))
+          continue;
+        // Casts of a void return value are not needed.
+        if (NewRetTy->isVoidTy() && isa<CastInst>(UI) && UI->use_empty())
+          DeadCasts.push_back(UI);
+        else
+          RetValUses.push_back(&U);
+      }
+      for (Instruction *I : DeadCasts)
+        I->eraseFromParent();
+
+      CI->mutateFunctionType(NewF->getFunctionType());
+      CI->setCalledFunction(NewF);
+      if (NewRetTy->isVoidTy())
+        CI->setName("");
+      if (RetValUses.empty())
+        continue;
+      Value *RetVal = castReturnValue(CI, OldRetTy, CI->getNextNode());
+      for (Use *U : RetValUses)
+        U->set(RetVal);
+    }
+  }
+
+  // Make the returns of each changed function return its new type, and
+  // unify them again.
+  legacy::FunctionPassManager FPM(M);
+  FPM.add(createUnifyFunctionExitNodesPass());
+  FPM.doInitialization();
+  for (auto &NF : NewFuncs) {
+    Function *NewF = NF.second;
+    Type *NewRetTy = NewF->getReturnType();
+    for (BasicBlock &BB : *NewF) {
+      auto *RI = dyn_cast_or_null<ReturnInst>(BB.getTerminator());
+      if (RI == nullptr)
+        continue;
+      Value *RetVal = RI->getReturnValue();
+      if (NewRetTy->isVoidTy()) {
+        if (RetVal == nullptr)
+          continue;
+        RetVal = nullptr;
+      } else if (RetVal == nullptr) {
+        RetVal = UndefValue::get(NewRetTy);
+      } else if (RetVal->getType() != NewRetTy) {
+        RetVal = castReturnValue(RetVal, NewRetTy, RI);
+      } else
+        continue;
+      ReturnInst::Create(NewF->getContext(), RetVal, RI);
+      RI->eraseFromParent();
+    }
+    FPM.run(*NewF);
+  }
+  FPM.doFinalization();
+
+  // Delete the old functions.
+  for (auto &NF : NewFuncs) {
+    Function *OldF = NF.first;
+    if (!OldF->use_empty())
+      OldF->replaceAllUsesWith(
+          ConstantExpr::getBitCast(NF.second, OldF->getType()));
+    OldF->eraseFromParent();
+  }
+  return true;
+}
+
+// Return true if Obj is an executable, i.e., either a non-PIE executable or a
+// position independent executable that requests a program interpreter.
+static bool isExecutableObject(const ELFObjectFileBase *ELFObj) {
+  if (ELFObj->getEType() == ELF::ET_EXEC)
+    return true;
+
+  if (ELFObj->getEType() != ELF::ET_DYN)
+    return false;
+
+  for (const SectionRef &Sec : ELFObj->sections()) {
+    Expected<StringRef> SecName = Sec.getName();
+    if (SecName && SecName->equals(".interp"))
+      return true;
+    consumeError(SecName.takeError());
+  }
+  return false;
+}
+
+// Functions of an executable that are not reachable from outside the module
+// can have internal linkage and use fastcc. This enables inlining, IPSCCP,
+// dead argument elimination and calling convention changes when the raised
+// module is recompiled. A function is reachable from outside if it is in the
+// dynamic symbol table, is referenced by a relocation, or its address is
+// taken in the raised module.
+bool ModuleRaiser::internalizeRaisedFunctions() {
+  const ELFObjectFileBase *ELFObj = dyn_cast<ELFObjectFileBase>(Obj);
+  if (ELFObj == nullptr || !isExecutableObject(ELFObj))
+    return false;
+
+  // Names of symbols exported by or referenced from dynamic symbol table and
+  // relocations.
+  StringSet<> ReferencedSyms;
+  // Addresses referenced by relocations without symbols, e.g., R_*_RELATIVE.
+  DenseSet<uint64_t> ReferencedAddrs;
+
+  for (const ELFSymbolRef &Sym : ELFObj->getDynamicSymbolIterators()) {
+    Expected<StringRef> SymName = Sym.getName();
+    if (SymName)
+      ReferencedSyms.insert(*SymName);
+    else
+      consumeError(SymName.takeError());
+  }
+
+  auto CollectRelocRefs = [&](const std::vector<RelocationRef> &Relocs) {
+    for (const RelocationRef &Reloc : Relocs) {
+      symbol_iterator SymIter = Reloc.getSymbol();
+      if (SymIter != Obj->symbol_end()) {
+        Expected<StringRef> SymName = SymIter->getName();
+        if (SymName) {
+          ReferencedSyms.insert(*SymName);
+          continue;
         }
+        consumeError(SymName.takeError());
       }
+      Expected<int64_t> Addend = ELFRelocationRef(Reloc).getAddend();
+      if (Addend)
+        ReferencedAddrs.insert(*Addend);
+      else
+        consumeError(Addend.takeError());
     }
-    // Delete old function signature from function list
-    TargetFunc->getParent()->getFunctionList().remove(
-        TargetFunc->getIterator());
-    // Update raised function
-    TargetFuncMFRaiser->setRaisedFunction(NewF);
+  };
+  CollectRelocRefs(DynRelocs);
+  CollectRelocRefs(TextRelocs);
+
+  int64_t TextSecAddr = getTextSectionAddress();
+  bool Changed = false;
+  for (auto MFR : mfRaiserVector) {
+    Function *F = MFR->getRaisedFunction();
+    if (F == nullptr || F->isDeclaration() || !F->hasExternalLinkage() ||
+        F->isVarArg() || F->getName().equals("main"))
+      continue;
+
+    uint64_t FuncAddr = MFR->getMCInstRaiser()->getFuncStart() + TextSecAddr;
+    if (ReferencedSyms.count(F->getName()) ||
+        ReferencedAddrs.count(FuncAddr) || F->hasAddressTaken())
+      continue;
+
+    // Not address-taken, so all uses are direct calls. Do not change
+    // functions called with a mismatched type.
+    bool AllCallsMatch = llvm::all_of(F->users(), [F](const User *U) {
+      const CallBase *CB = dyn_cast<CallBase>(U);
+      return CB != nullptr && CB->getFunctionType() == F->getFunctionType();
+    });
+    if (!AllCallsMatch)
+      continue;
+
+    LLVM_DEBUG(dbgs() << "Internalizing " << F->getName() << "\n");
+    F->setLinkage(GlobalValue::InternalLinkage);
+    F->setCallingConv(CallingConv::Fast);
+    for (User *U : F->users())
+      cast<CallBase>(U)->setCallingConv(CallingConv::Fast);
     Changed = true;
   }
   return Changed;
 }
+
+// Return true if Reloc is a copy relocation of object file Obj.
+static bool isCopyRelocation(const ObjectFile *Obj,
+                             const RelocationRef &Reloc) {
+  switch (Obj->getArch()) {
+  case Triple::x86_64:
+    return Reloc.getType() == ELF::R_X86_64_COPY;
+  case Triple::x86:
+    return Reloc.getType() == ELF::R_386_COPY;
+  case Triple::arm:
+  case Triple::thumb:
+    return Reloc.getType() == ELF::R_ARM_COPY;
+  case Triple::aarch64:
+    return Reloc.getType() == ELF::R_AARCH64_COPY;
+  case Triple::riscv32:
+  case Triple::riscv64:
+    return Reloc.getType() == ELF::R_RISCV_COPY;
+  default:
+    return false;
+  }
+}
+
+bool ModuleRaiser::prepareForProgramLink() {
+  if (!Obj->isELF())
+    return false;
+
+  // A name may be bound both locally and globally in the same object.
+  StringSet<> LocalSyms;
+  StringSet<> GlobalSyms;
+  for (const SymbolRef &Sym : Obj->symbols()) {
+    Expected<StringRef> SymName = Sym.getName();
+    if (!SymName) {
+      consumeError(SymName.takeError());
+      continue;
+    }
+    if (SymName->empty())
+      continue;
+    if (ELFSymbolRef(Sym).getBinding() == ELF::STB_LOCAL)
+      LocalSyms.insert(*SymName);
+    else
+      GlobalSyms.insert(*SymName);
+  }
+
+  bool Changed = false;
+  for (const auto &Sym : LocalSyms) {
+    if (GlobalSyms.count(Sym.getKey()))
+      continue;
+    GlobalValue *GV = M->getNamedValue(Sym.getKey());
+    if (GV == nullptr || GV->isDeclaration() || GV->hasLocalLinkage())
+      continue;
+    LLVM_DEBUG(dbgs() << "Giving " << GV->getName() << " internal linkage\n");
+    GV->setLinkage(GlobalValue::InternalLinkage);
+    Changed = true;
+  }
+
+  for (const RelocationRef &Reloc : DynRelocs) {
+    if (!isCopyRelocation(Obj, Reloc))
+      continue;
+    symbol_iterator SymIter = Reloc.getSymbol();
+    if (SymIter == Obj->symbol_end())
+      continue;
+    Expected<StringRef> SymName = SymIter->getName();
+    if (!SymName) {
+      consumeError(SymName.takeError());
+      continue;
+    }
+    GlobalVariable *GV = M->getGlobalVariable(*SymName);
+    if (GV == nullptr)
+      continue;
+    GV->setInitializer(nullptr);
+    GV->setLinkage(GlobalValue::ExternalLinkage);
+    Changed = true;
+  }
+  return Changed;
+}
+
+// Return true if Ptr refers to a stack object of the function it is used in.
+static bool isLocalMemory(const Value *Ptr) {
+  return isa<AllocaInst>(getUnderlyingObject(Ptr));
+}
+
+// Add the attributes that hold for all functions of the call graph SCC, given
+// the attributes of the functions called from it. Functions of the SCC are
+// assumed to behave alike, as any of them may reach the others.
+static bool inferSCCAttributes(const SmallPtrSetImpl<Function *> &SCC,
+                               bool SCCHasCycle) {
+  bool ReadsMem = false;
+  bool WritesMem = false;
+  bool MayUnwind = false;
+  bool MayFree = false;
+  bool MayNotReturn = SCCHasCycle;
+  bool MayRecurse = SCCHasCycle;
+
+  for (Function *F : SCC) {
+    // A loop in the CFG may not terminate.
+    for (scc_iterator<Function *> I = scc_begin(F); !I.isAtEnd(); ++I)
+      if (I.hasCycle())
+        MayNotReturn = true;
+
+    for (Instruction &I : instructions(*F)) {
+      if (auto *LI = dyn_cast<LoadInst>(&I)) {
+        if (LI->isVolatile() || !isLocalMemory(LI->getPointerOperand()))
+          ReadsMem = true;
+        continue;
+      }
+      if (auto *SI = dyn_cast<StoreInst>(&I)) {
+        if (SI->isVolatile() || !isLocalMemory(SI->getPointerOperand()))
+          WritesMem = true;
+        continue;
+      }
+      auto *CB = dyn_cast<CallBase>(&I);
+      if (CB == nullptr) {
+        if (I.mayReadFromMemory())
+          ReadsMem = true;
+        if (I.mayWriteToMemory())
+          WritesMem = true;
+        continue;
+      }
+
+      Function *Callee = CB->getCalledFunction();
+      // Effects of calls within the SCC are those of the SCC itself.
+      if (Callee != nullptr && SCC.count(Callee))
+        continue;
+
+      if (Callee == nullptr) {
+        // Nothing is known about the target of an indirect call.
+        ReadsMem = WritesMem = MayUnwind = MayFree = true;
+        MayNotReturn = MayRecurse = true;
+        continue;
+      }
+
+      if (!Callee->doesNotAccessMemory()) {
+        ReadsMem = true;
+        if (!Callee->onlyReadsMemory())
+          WritesMem = true;
+      }
+      MayUnwind |= !Callee->doesNotThrow();
+      MayFree |= !Callee->doesNotFreeMemory();
+      MayNotReturn |= !Callee->willReturn();
+      MayRecurse |= !Callee->isIntrinsic() && !Callee->doesNotRecurse();
+    }
+  }
+
+  bool Changed = false;
+  auto AddAttr = [&Changed](Function *F, Attribute::AttrKind Kind) {
+    if (!F->hasFnAttribute(Kind)) {
+      F->addFnAttr(Kind);
+      Changed = true;
+    }
+  };
+
+  for (Function *F : SCC) {
+    if (!WritesMem) {
+      // readnone and readonly are mutually exclusive.
+      if (!ReadsMem) {
+        F->removeFnAttr(Attribute::ReadOnly);
+        AddAttr(F, Attribute::ReadNone);
+      } else if (!F->doesNotAccessMemory())
+        AddAttr(F, Attribute::ReadOnly);
+    }
+    if (!MayUnwind)
+      AddAttr(F, Attribute::NoUnwind);
+    if (!MayFree)
+      AddAttr(F, Attribute::NoFree);
+    if (!MayNotReturn)
+      AddAttr(F, Attribute::WillReturn);
+    if (!MayRecurse)
+      AddAttr(F, Attribute::NoRecurse);
+  }
+  return Changed;
+}
+
+bool ModuleRaiser::inferFunctionAttributes() {
+  bool Changed = false;
+
+  // Calls to library functions whose prototypes were given via -I or are
+  // built in get the attributes LLVM knows for them.
+  TargetLibraryInfoImpl TLII(Triple(M->getTargetTriple()));
+  TargetLibraryInfo TLI(TLII);
+  for (Function &F : *M) {
+    LibFunc LF;
+    if (F.isDeclaration() &&
+        ExternalFunctions::UserSpecifiedFunctions.count(F.getName().str()) &&
+        TLI.getLibFunc(F, LF))
+      Changed |= inferLibFuncAttributes(F, TLI);
+  }
+
+  // Visit the call graph bottom-up so that attributes of callees are known
+  // when their callers are visited.
+  CallGraph CG(*M);
+  for (scc_iterator<CallGraph *> I = scc_begin(&CG); !I.isAtEnd(); ++I) {
+    SmallPtrSet<Function *, 8> SCCFunctions;
+    bool IsDefinedSCC = true;
+    for (CallGraphNode *Node : *I) {
+      Function *F = Node->getFunction();
+      if (F == nullptr || F->isDeclaration()) {
+        IsDefinedSCC = false;
+        break;
+      }
+      SCCFunctions.insert(F);
+    }
+    if (IsDefinedSCC)
+      Changed |= inferSCCAttributes(SCCFunctions, I.hasCycle());
+  }
+  return Changed;
+}
+
+bool ModuleRaiser::setFunctionEntryCounts() {
+  bool Changed = false;
+  int64_t TextSectionAddress = getTextSectionAddress();
+  for (auto MFR : mfRaiserVector) {
+    Function *F = MFR->getRaisedFunction();
+    uint64_t Count = BranchProfile::getTargetCount(
+        TextSectionAddress + MFR->getMCInstRaiser()->getFuncStart());
+    if (Count != 0) {
+      F->setEntryCount(Function::ProfileCount(Count, Function::PCT_Real));
+      Changed = true;
+    }
+  }
+  return Changed;
+}
+
+void ModuleRaiser::enableAddressDebugInfo() {
+  assert(InfoSet && "Module Raiser information not set");
+  AddrDIBuilder = std::make_unique<DIBuilder>(*M);
+  StringRef FileName = sys::path::filename(Obj->getFileName());
+  StringRef Directory = sys::path::parent_path(Obj->getFileName());
+  AddrDIFile = AddrDIBuilder->createFile(FileName, Directory);
+  AddrDIBuilder->createCompileUnit(dwarf::DW_LANG_C, AddrDIFile, "llvm-mctoll",
+                                   /* isOptimized */ false, "", 0, "",
+                                   DICompileUnit::LineTablesOnly);
+  M->addModuleFlag(Module::Warning, "Dwarf Version", dwarf::DWARF_VERSION);
+  M->addModuleFlag(Module::Warning, "Debug Info Version",
+                   DEBUG_METADATA_VERSION);
+}
+
+DISubprogram *ModuleRaiser::getOrCreateAddressSubprogram(Function *F,
+                                                         uint64_t Addr) const {
+  if (AddrDIBuilder == nullptr)
+    return nullptr;
+  if (DISubprogram *SP = F->getSubprogram())
+    return SP;
+  DISubroutineType *Ty = AddrDIBuilder->createSubroutineType(
+      AddrDIBuilder->getOrCreateTypeArray(None));
+  // Line numbers are 32-bit; higher address bits are not recorded.
+  unsigned Line = static_cast<unsigned>(Addr);
+  DISubprogram *SP = AddrDIBuilder->createFunction(
+      AddrDIFile, F->getName(), StringRef(), AddrDIFile, Line, Ty, Line,
+      DINode::FlagZero, DISubprogram::SPFlagDefinition);
+  F->setSubprogram(SP);
+  return SP;
+}
+
+void ModuleRaiser::finalizeAddressDebugInfo() {
+  if (AddrDIBuilder == nullptr)
+    return;
+  int64_t TextSectionAddress = getTextSectionAddress();
+  for (auto MFR : mfRaiserVector) {
+    Function *F = MFR->getRaisedFunction();
+    if (F->isDeclaration())
+      continue;
+    DISubprogram *SP = getOrCreateAddressSubprogram(
+        F, TextSectionAddress + MFR->getMCInstRaiser()->getFuncStart());
+    // Instructions not raised from a single machine instruction, such as
+    // stack frame allocas, are attributed to the function start. This also
+    // satisfies the requirement that calls in a function with debug
+    // information have a location.
+    DebugLoc FuncStartLoc =
+        DILocation::get(F->getContext(), SP->getLine(), 0, SP);
+    for (Instruction &I : instructions(*F))
+      if (!I.getDebugLoc())
+        I.setDebugLoc(FuncStartLoc);
+  }
+  AddrDIBuilder->finalize();
+}
+
+void ModuleRaiser::enableRaisedFunctionCache(StringRef Dir,
+                                             StringRef ToolContext) {
+  assert(InfoSet && "Module raiser information must be set first");
+  FunctionCache = std::make_unique<RaisedFunctionCache>(Dir);
+  CacheToolContext = ToolContext.str();
+}
+
+// Add V to the hash H.
+static void hashInt(SHA1 &H, uint64_t V) {
+  uint8_t Bytes[sizeof(V)];
+  support::endian::write64le(Bytes, V);
+  H.update(makeArrayRef(Bytes));
+}
+
+// Add S to the hash H, such that consecutive strings are distinguished from
+// their concatenation.
+static void hashString(SHA1 &H, StringRef S) {
+  hashInt(H, S.size());
+  H.update(S);
+}
+
+// Add the offset relative to Base, type, symbol name and addend of R to the
+// hash H.
+static void hashRelocation(SHA1 &H, const RelocationRef &R, uint64_t Base = 0) {
+  hashInt(H, R.getOffset() - Base);
+  hashInt(H, R.getType());
+  const ObjectFile *Obj = R.getObject();
+  symbol_iterator Sym = R.getSymbol();
+  if (Sym != Obj->symbol_end()) {
+    Expected<StringRef> Name = Sym->getName();
+    if (Name)
+      hashString(H, *Name);
+    else
+      consumeError(Name.takeError());
+  }
+  if (Obj->isELF()) {
+    Expected<int64_t> Addend = ELFRelocationRef(R).getAddend();
+    if (Addend)
+      hashInt(H, *Addend);
+    else
+      consumeError(Addend.takeError());
+  }
+}
+
+// Return the name of section Sec, or an empty string if it has none.
+static StringRef getSectionName(const SectionRef &Sec) {
+  Expected<StringRef> NameOrErr = Sec.getName();
+  if (NameOrErr)
+    return *NameOrErr;
+  consumeError(NameOrErr.takeError());
+  return StringRef();
+}
+
+bool ModuleRaiser::symbolizesCacheKeyAddresses() const {
+  // Sections of relocatable objects all start at address 0, and their
+  // references are described by relocations.
+  return Obj->isELF() && !Obj->isRelocatableObject() && TextSectionIndex >= 0;
+}
+
+std::string ModuleRaiser::getRaisedFunctionCacheContext() const {
+  SHA1 H;
+  hashString(H, CacheToolContext);
+  hashString(H, M->getTargetTriple());
+  hashString(H, M->getDataLayoutStr());
+
+  // Calls of external functions are raised with these prototypes.
+  for (auto &Proto : ExternalFunctions::UserSpecifiedFunctions) {
+    hashString(H, Proto.first);
+    hashString(H, Proto.second.ReturnType);
+    hashInt(H, Proto.second.isVariadic);
+    hashInt(H, Proto.second.Arguments.size());
+    for (auto &Arg : Proto.second.Arguments)
+      hashString(H, Arg);
+  }
+
+  // Keys of functions of executables and shared libraries describe the
+  // symbols, relocations and data their instructions refer to. Otherwise,
+  // raised functions may depend on any data section and data symbol.
+  if (symbolizesCacheKeyAddresses())
+    return toHex(H.final(), /*LowerCase=*/true);
+
+  hashInt(H, TextSectionIndex < 0 ? -1 : getTextSectionAddress());
+  // Unwind tables change with any code and are not read while raising.
+  for (const SectionRef &Sec : Obj->sections()) {
+    if (!Sec.isData() && !Sec.isBSS())
+      continue;
+    StringRef SecName = getSectionName(Sec);
+    if (SecName.startswith(".eh_frame"))
+      continue;
+    hashString(H, SecName);
+    hashInt(H, Sec.getAddress());
+    hashInt(H, Sec.getSize());
+    if (Sec.isBSS())
+      continue;
+    Expected<StringRef> Contents = Sec.getContents();
+    if (Contents)
+      hashString(H, *Contents);
+    else
+      consumeError(Contents.takeError());
+  }
+
+  // Global variables are raised for data symbols and for symbols of dynamic
+  // relocations.
+  for (const SymbolRef &Sym : Obj->symbols()) {
+    Expected<SymbolRef::Type> Type = Sym.getType();
+    if (!Type) {
+      consumeError(Type.takeError());
+      continue;
+    }
+    if (*Type != SymbolRef::ST_Data)
+      continue;
+    Expected<StringRef> Name = Sym.getName();
+    Expected<uint64_t> Addr = Sym.getAddress();
+    if (!Name || !Addr) {
+      consumeError(Name.takeError());
+      consumeError(Addr.takeError());
+      continue;
+    }
+    hashString(H, *Name);
+    hashInt(H, *Addr);
+  }
+  for (const RelocationRef &R : DynRelocs)
+    hashRelocation(H, R);
+  return toHex(H.final(), /*LowerCase=*/true);
+}
+
+// Kinds of address references in raised function cache keys.
+enum CacheKeyAddressRef {
+  CKA_FunctionOffset = 1,
+  CKA_FunctionName,
+  CKA_DynReloc,
+  CKA_DataSymbol,
+  CKA_DataSection,
+  CKA_Stub
+};
+
+bool ModuleRaiser::hashAddressReference(
+    SHA1 &H, uint64_t Addr, const MCInstRaiser *MCIR,
+    const DenseMap<uint64_t, StringRef> &FuncNameAt, bool FollowStub) const {
+  // Raised code refers to functions by name and to the function itself by
+  // offset.
+  uint64_t TextSecAddr = getTextSectionAddress();
+  if (Addr >= TextSecAddr) {
+    uint64_t Offset = Addr - TextSecAddr;
+    if (Offset >= MCIR->getFuncStart() && Offset < MCIR->getFuncEnd()) {
+      hashInt(H, CKA_FunctionOffset);
+      hashInt(H, Offset - MCIR->getFuncStart());
+      return true;
+    }
+    auto Name = FuncNameAt.find(Offset);
+    if (Name != FuncNameAt.end()) {
+      hashInt(H, CKA_FunctionName);
+      hashString(H, Name->second);
+      return true;
+    }
+  }
+
+  // Only addresses in sections are raised to references. Like the raiser,
+  // take the first section holding Addr or ending at it.
+  Optional<SectionRef> Sec;
+  for (const SectionRef &S : Obj->sections())
+    if (S.getAddress() <= Addr && Addr <= S.getAddress() + S.getSize()) {
+      Sec = S;
+      break;
+    }
+  if (!Sec.hasValue() || !(Sec->isData() || Sec->isBSS() || Sec->isText()))
+    return false;
+
+  bool Described = false;
+  // Accesses of GOT entries and copy relocated variables are raised to the
+  // global variables of the symbols of their dynamic relocations.
+  if (const RelocationRef *R = getDynRelocAtOffset(Addr)) {
+    hashInt(H, CKA_DynReloc);
+    hashRelocation(H, *R, Addr);
+    Described = true;
+  }
+
+  // Otherwise, they are raised to the global variable of the data symbol
+  // holding Addr, whose initial value is read from the binary.
+  for (const ELFSymbolRef &Sym : cast<ELFObjectFileBase>(Obj)->symbols()) {
+    uint8_t Type = Sym.getELFType();
+    if (Type != ELF::STT_OBJECT && Type != ELF::STT_FUNC)
+      continue;
+    Expected<uint64_t> SymAddr = Sym.getAddress();
+    if (!SymAddr) {
+      consumeError(SymAddr.takeError());
+      continue;
+    }
+    uint64_t SymSize = Sym.getSize();
+    if (*SymAddr > Addr || *SymAddr + SymSize <= Addr)
+      continue;
+    // Functions are only referenced at their start.
+    if (Type == ELF::STT_FUNC)
+      return Described;
+    Expected<StringRef> Name = Sym.getName();
+    if (!Name) {
+      consumeError(Name.takeError());
+      return Described;
+    }
+    Expected<section_iterator> SymSec = Sym.getSection();
+    if (!SymSec) {
+      consumeError(SymSec.takeError());
+      return Described;
+    }
+    if (*SymSec == Obj->section_end())
+      return Described;
+    hashInt(H, CKA_DataSymbol);
+    hashString(H, *Name);
+    hashInt(H, Addr - *SymAddr);
+    hashInt(H, SymSize);
+    hashInt(H, Sym.getBinding());
+    if ((*SymSec)->isBSS())
+      return true;
+    Expected<StringRef> Contents = (*SymSec)->getContents();
+    if (!Contents) {
+      consumeError(Contents.takeError());
+      return false;
+    }
+    uint64_t SymOffset = *SymAddr - (*SymSec)->getAddress();
+    hashString(H, Contents->substr(SymOffset, SymSize));
+    return true;
+  }
+
+  // Other data is raised to an offset into the global variable holding the
+  // contents of its section, which is read from the binary raising the
+  // cached function when it is loaded.
+  if (Sec->isData()) {
+    hashInt(H, CKA_DataSection);
+    hashString(H, getSectionName(*Sec));
+    hashInt(H, Sec->getIndex());
+    hashInt(H, Sec->getSize());
+    hashInt(H, Addr - Sec->getAddress());
+    return true;
+  }
+
+  // Calls of PLT entries are raised to calls of the function of the dynamic
+  // relocation of the GOT entry the entry jumps through.
+  if (Sec->isText() && FollowStub && !Described) {
+    Expected<StringRef> Contents = Sec->getContents();
+    if (!Contents) {
+      consumeError(Contents.takeError());
+      return false;
+    }
+    ArrayRef<uint8_t> Bytes(Contents->bytes_begin(), Contents->bytes_end());
+    uint64_t Index = Addr - Sec->getAddress();
+    // Skip an endbr instruction at the start of the entry.
+    for (unsigned I = 0; I < 2 && Index < Bytes.size(); ++I) {
+      MCInst Inst;
+      uint64_t Size;
+      if (!DisAsm->getInstruction(Inst, Size, Bytes.slice(Index),
+                                  Sec->getAddress() + Index, nulls()))
+        return false;
+      Optional<uint64_t> EA = MIA->evaluateMemoryOperandAddress(
+          Inst, Sec->getAddress() + Index, Size);
+      if (EA.hasValue()) {
+        const RelocationRef *R = getDynRelocAtOffset(*EA);
+        if (R == nullptr)
+          return false;
+        hashInt(H, CKA_Stub);
+        hashRelocation(H, *R, *EA);
+        return true;
+      }
+      Index += Size;
+    }
+  }
+  return Described;
+}
+
+std::string ModuleRaiser::getRaisedFunctionCacheKey(
+    MachineFunctionRaiser *MFR, StringRef Context,
+    const DenseMap<uint64_t, StringRef> &FuncNameAt) const {
+  SHA1 H;
+  hashString(H, Context);
+  MCInstRaiser *MCIR = MFR->getMCInstRaiser();
+  uint64_t Start = MCIR->getFuncStart();
+  uint64_t End = MCIR->getFuncEnd();
+  hashString(H, MFR->getMachineFunction().getName());
+  hashInt(H, End - Start);
+
+  // Instructions are hashed at their offset into the function. The targets
+  // of PC-relative operands, and addresses held by immediates, are described
+  // by the functions, relocations, symbols and data they refer to, so that a
+  // function that moves, or whose unrelated data changes, keeps its key.
+  // Absolute addresses are hashed as well, as raised code may hold them.
+  bool Symbolize = symbolizesCacheKeyAddresses();
+  int64_t TextSecAddr = TextSectionIndex < 0 ? -1 : getTextSectionAddress();
+  auto HashFuncNameAt = [&H, &FuncNameAt](uint64_t Offset) {
+    auto Name = FuncNameAt.find(Offset);
+    hashString(H, Name == FuncNameAt.end() ? StringRef() : Name->second);
+  };
+  for (auto I = MCIR->const_mcinstr_begin(), E = MCIR->const_mcinstr_end();
+       I != E; ++I) {
+    hashInt(H, I->first - Start);
+    if (I->second.isData()) {
+      hashInt(H, 0);
+      hashInt(H, I->second.getData());
+      continue;
+    }
+    MCInst Inst = I->second.getMCInst();
+    uint64_t Size = MCIR->getMCInstSize(I->first);
+    hashInt(H, 1);
+    hashInt(H, Size);
+    hashInt(H, Inst.getOpcode());
+    hashInt(H, Inst.getNumOperands());
+
+    // The PC-relative displacement of the instruction, if any, and the
+    // address it refers to.
+    Optional<int64_t> Disp;
+    uint64_t Target = 0;
+    bool DispHashed = false;
+    if (Symbolize) {
+      uint64_t InstAddr = TextSecAddr + I->first;
+      if ((MIA->isCall(Inst) || MIA->isBranch(Inst)) &&
+          MIA->evaluateBranch(Inst, InstAddr, Size, Target))
+        Disp = Target - (InstAddr + Size);
+      else if (Optional<uint64_t> EA =
+                   MIA->evaluateMemoryOperandAddress(Inst, InstAddr, Size)) {
+        Target = *EA;
+        Disp = Target - (InstAddr + Size);
+      }
+    }
+
+    for (const MCOperand &Op : Inst) {
+      if (Op.isReg()) {
+        hashInt(H, 1);
+        hashInt(H, Op.getReg());
+      } else if (Op.isImm()) {
+        if (Disp.hasValue() && !DispHashed && Op.getImm() == *Disp) {
+          // Hashed as the reference to its target below.
+          hashInt(H, 4);
+          DispHashed = true;
+          continue;
+        }
+        hashInt(H, 2);
+        hashInt(H, Op.getImm());
+        if (Symbolize)
+          hashAddressReference(H, Op.getImm(), MCIR, FuncNameAt,
+                               /*FollowStub=*/false);
+        else if (TextSecAddr >= 0 && Op.getImm() >= TextSecAddr)
+          HashFuncNameAt(Op.getImm() - TextSecAddr);
+      } else
+        hashInt(H, 3);
+    }
+    if (Symbolize) {
+      if (DispHashed && !hashAddressReference(H, Target, MCIR, FuncNameAt,
+                                              /*FollowStub=*/true))
+        hashInt(H, Target);
+      continue;
+    }
+    if ((MIA->isCall(Inst) || MIA->isBranch(Inst)) &&
+        MIA->evaluateBranch(Inst, I->first, Size, Target) &&
+        !MCIR->isMCInstInRange(Target))
+      HashFuncNameAt(Target);
+  }
+
+  auto R = llvm::lower_bound(TextRelocs, Start,
+                             [](const RelocationRef &R, uint64_t Offset) {
+                               return R.getOffset() < Offset;
+                             });
+  for (; R != TextRelocs.end() && R->getOffset() < End; ++R)
+    hashRelocation(H, *R, Start);
+  return toHex(H.final(), /*LowerCase=*/true);
+}
+
+bool ModuleRaiser::updateRaisedSectionContents(GlobalVariable &GV,
+                                               const Function &F) const {
+  // The raiser names the variable after the section and its index.
+  Optional<SectionRef> Sec;
+  for (const SectionRef &S : Obj->sections()) {
+    StringRef SecName = getSectionName(S);
+    std::string Name = SecName.empty() ? std::string("AnonDataSec")
+                                       : SecName.substr(1).str();
+    if (Name + "_" + std::to_string(S.getIndex()) == GV.getName()) {
+      Sec = S;
+      break;
+    }
+  }
+  auto *Ty = dyn_cast<ArrayType>(GV.getValueType());
+  if (!Sec.hasValue() || !Sec->isData() || Ty == nullptr ||
+      Ty->getNumElements() != Sec->getSize())
+    return false;
+  Expected<StringRef> Contents = Sec->getContents();
+  if (!Contents) {
+    consumeError(Contents.takeError());
+    return false;
+  }
+
+  // Addresses loaded from the section are rebased using its start address,
+  // which F holds as a constant then.
+  MDNode *SecInfo = GV.getMetadata(RODATA_SEC_INFO_MD_STR);
+  uint64_t OldStart =
+      cast<ConstantInt>(
+          cast<ConstantAsMetadata>(SecInfo->getOperand(0))->getValue())
+          ->getZExtValue();
+  uint64_t NewStart = Sec->getAddress();
+  if (OldStart != NewStart)
+    for (const Instruction &I : instructions(F))
+      for (const Value *Op : I.operands())
+        if (auto *CI = dyn_cast<ConstantInt>(Op))
+          if (CI->getBitWidth() == 64 && CI->getZExtValue() == OldStart)
+            return false;
+
+  GV.setInitializer(ConstantDataArray::get(
+      GV.getContext(),
+      makeArrayRef(Contents->bytes_begin(), Contents->bytes_end())));
+  Type *Int64Ty = Type::getInt64Ty(GV.getContext());
+  GV.setMetadata(RODATA_SEC_INFO_MD_STR,
+                 MDNode::get(GV.getContext(),
+                             ConstantAsMetadata::get(
+                                 ConstantInt::get(Int64Ty, NewStart))));
+  return true;
+}
+
+bool ModuleRaiser::loadCachedRaisedFunction(MachineFunctionRaiser *MFR,
+                                            StringRef Key) {
+  std::unique_ptr<Module> CM = FunctionCache->load(Key, M->getContext());
+  if (CM == nullptr)
+    return false;
+  Function *Placeholder = &MFR->getMachineFunction().getFunction();
+  std::string Name = Placeholder->getName().str();
+  Function *CF = CM->getFunction(Name);
+  if (CF == nullptr || CF->isDeclaration())
+    return false;
+
+  // Bind each function and global variable the cached function refers to to
+  // the one of the same name in the module, which must be of the same type,
+  // or else move it to the module. Functions to be raised whose prototype is
+  // not known yet are represented by their placeholders and are not bound
+  // to.
+  SmallVector<GlobalValue *, 16> Bind;
+  SmallVector<GlobalValue *, 16> Move;
+  for (GlobalValue &GV : CM->global_values()) {
+    if (&GV == CF)
+      continue;
+    if (!isa<Function>(GV) && !isa<GlobalVariable>(GV))
+      return false;
+    // Keys do not cover the contents of data sections beyond the symbols
+    // referenced, so take those of the binary being raised.
+    if (auto *GVar = dyn_cast<GlobalVariable>(&GV))
+      if (GVar->hasMetadata(RODATA_SEC_INFO_MD_STR) &&
+          !updateRaisedSectionContents(*GVar, *CF))
+        return false;
+    GlobalValue *DstGV = M->getNamedValue(GV.getName());
+    if (DstGV == nullptr) {
+      Move.push_back(&GV);
+      continue;
+    }
+    if (DstGV->getType() != GV.getType() ||
+        isa<Function>(DstGV) != isa<Function>(GV))
+      return false;
+    if (auto *DstF = dyn_cast<Function>(DstGV))
+      if (MMI->getMachineFunction(*DstF) != nullptr)
+        return false;
+    Bind.push_back(&GV);
+  }
+  for (GlobalValue *GV : Bind)
+    GV->replaceAllUsesWith(M->getNamedValue(GV->getName()));
+
+  // Replace the placeholder like prototype discovery does, and move the body
+  // of the cached function into the raised function.
+  M->getFunctionList().remove(Placeholder);
+  Function *F = Function::Create(CF->getFunctionType(), CF->getLinkage(),
+                                 CF->getAddressSpace(), Name, M);
+  F->copyAttributesFrom(CF);
+  F->getBasicBlockList().splice(F->begin(), CF->getBasicBlockList());
+  for (Function::arg_iterator I = CF->arg_begin(), E = CF->arg_end(),
+                              I2 = F->arg_begin();
+       I != E; ++I, ++I2) {
+    I->replaceAllUsesWith(&*I2);
+    I2->takeName(&*I);
+  }
+  CF->replaceAllUsesWith(F);
+  for (GlobalValue *GV : Move) {
+    GV->removeFromParent();
+    if (auto *MovedF = dyn_cast<Function>(GV))
+      M->getFunctionList().push_back(MovedF);
+    else
+      M->getGlobalList().push_back(cast<GlobalVariable>(GV));
+  }
+
+  MFR->setRaisedFunction(F);
+  insertPlaceholderRaisedFunctionMap(F, Placeholder);
+  return true;
+}
+
+// Maximum number of targets an indirect call is promoted to. Calls with more
+// possible targets are left alone.
+static const unsigned MaxPromotedCallTargets = 4;
+// Maximum depth of values walked to find targets of an indirect call.
+static const unsigned MaxCallTargetSearchDepth = 8;
+
+namespace {
+// How the called pointer of an indirect call may refer to a possible target:
+// as the raised function itself, or as the address of the function in the
+// binary, which raised data tables and immediates hold.
+struct CallTargetRefs {
+  bool ByFunction = false;
+  Optional<uint64_t> ByAddress;
+};
+} // end anonymous namespace
+
+using CallTargetMap = MapVector<Function *, CallTargetRefs>;
+
+// Add the raised function at address Addr, if any, to Targets.
+static void addCallTargetAt(uint64_t Addr, const ModuleRaiser &MR,
+                            CallTargetMap &Targets) {
+  if (Function *F = MR.getRaisedFunctionAt(Addr))
+    Targets[F].ByAddress = Addr;
+}
+
+// Add the functions whose addresses are in the initializer C to Targets.
+// Function pointer tables in data are raised as arrays of integer addresses.
+static void
+collectInitializerCallTargets(Constant *C, const ModuleRaiser &MR,
+                              CallTargetMap &Targets) {
+  if (auto *CDS = dyn_cast<ConstantDataSequential>(C)) {
+    if (CDS->getElementType()->isIntegerTy())
+      for (unsigned I = 0, E = CDS->getNumElements(); I != E; ++I)
+        addCallTargetAt(CDS->getElementAsInteger(I), MR, Targets);
+    return;
+  }
+  if (isa<ConstantAggregate>(C)) {
+    for (Use &Op : C->operands())
+      collectInitializerCallTargets(cast<Constant>(Op), MR, Targets);
+    return;
+  }
+  if (auto *CI = dyn_cast<ConstantInt>(C)) {
+    addCallTargetAt(CI->getZExtValue(), MR, Targets);
+    return;
+  }
+  if (auto *F = dyn_cast<Function>(C->stripPointerCasts()))
+    Targets[F].ByFunction = true;
+}
+
+// Return the global variable the address Ptr is computed from, or nullptr.
+static GlobalVariable *getAddressedGlobal(Value *Ptr, unsigned Depth) {
+  if (Depth > MaxCallTargetSearchDepth)
+    return nullptr;
+  if (auto *GV = dyn_cast<GlobalVariable>(Ptr))
+    return GV;
+  if (auto *CE = dyn_cast<ConstantExpr>(Ptr)) {
+    if (CE->isCast() || CE->getOpcode() == Instruction::GetElementPtr)
+      return getAddressedGlobal(CE->getOperand(0), Depth + 1);
+    return nullptr;
+  }
+  if (auto *CI = dyn_cast<CastInst>(Ptr))
+    return getAddressedGlobal(CI->getOperand(0), Depth + 1);
+  if (auto *GEP = dyn_cast<GetElementPtrInst>(Ptr))
+    return getAddressedGlobal(GEP->getPointerOperand(), Depth + 1);
+  // Table base plus scaled index.
+  if (auto *BO = dyn_cast<BinaryOperator>(Ptr)) {
+    if (BO->getOpcode() != Instruction::Add)
+      return nullptr;
+    if (GlobalVariable *GV = getAddressedGlobal(BO->getOperand(0), Depth + 1))
+      return GV;
+    return getAddressedGlobal(BO->getOperand(1), Depth + 1);
+  }
+  return nullptr;
+}
+
+// Add the functions the value V may hold to Targets. Values that can not be
+// determined are ignored; calls to them take the fallback indirect call.
+static void collectCallTargets(Value *V, const ModuleRaiser &MR,
+                               CallTargetMap &Targets,
+                               SmallPtrSetImpl<Value *> &Visited,
+                               unsigned Depth) {
+  if (Depth > MaxCallTargetSearchDepth || !Visited.insert(V).second)
+    return;
+  if (auto *F = dyn_cast<Function>(V)) {
+    Targets[F].ByFunction = true;
+    return;
+  }
+  // Function addresses materialized as immediates, e.g., by lea.
+  if (auto *CI = dyn_cast<ConstantInt>(V)) {
+    addCallTargetAt(CI->getZExtValue(), MR, Targets);
+    return;
+  }
+  if (auto *CE = dyn_cast<ConstantExpr>(V)) {
+    if (CE->isCast())
+      collectCallTargets(CE->getOperand(0), MR, Targets, Visited, Depth + 1);
+    return;
+  }
+  if (auto *CI = dyn_cast<CastInst>(V)) {
+    collectCallTargets(CI->getOperand(0), MR, Targets, Visited, Depth + 1);
+    return;
+  }
+  if (auto *PN = dyn_cast<PHINode>(V)) {
+    for (Value *In : PN->incoming_values())
+      collectCallTargets(In, MR, Targets, Visited, Depth + 1);
+    return;
+  }
+  if (auto *SI = dyn_cast<SelectInst>(V)) {
+    collectCallTargets(SI->getTrueValue(), MR, Targets, Visited, Depth + 1);
+    collectCallTargets(SI->getFalseValue(), MR, Targets, Visited, Depth + 1);
+    return;
+  }
+  // A load from a table of function addresses may yield any of them. The
+  // table may be written at run time, which the guarded calls tolerate.
+  if (auto *LI = dyn_cast<LoadInst>(V)) {
+    GlobalVariable *GV = getAddressedGlobal(LI->getPointerOperand(), 0);
+    if (GV != nullptr && GV->hasDefinitiveInitializer())
+      collectInitializerCallTargets(GV->getInitializer(), MR, Targets);
+  }
+}
+
+// Return true if a value of type From can be converted to type To without
+// changing the bits that are passed in registers.
+static bool isCallValueConvertible(Type *From, Type *To,
+                                   const DataLayout &DL) {
+  if (From == To)
+    return true;
+  if (From->isIntegerTy() && To->isIntegerTy())
+    return true;
+  return CastInst::isBitOrNoopPointerCastable(From, To, DL);
+}
+
+static Value *convertCallValue(IRBuilder<> &IRB, Value *V, Type *To) {
+  if (V->getType() == To)
+    return V;
+  if (V->getType()->isIntegerTy() && To->isIntegerTy())
+    return IRB.CreateZExtOrTrunc(V, To);
+  return IRB.CreateBitOrPointerCast(V, To);
+}
+
+// Return true if the indirect call CB can be replaced by a call to F. Argument
+// values beyond the parameters of F are not read by it and are dropped.
+static bool isPromotableCallTarget(const CallBase &CB, const Function &F,
+                                   const DataLayout &DL) {
+  FunctionType *FT = F.getFunctionType();
+  if (FT->isVarArg() || FT->getNumParams() > CB.arg_size())
+    return false;
+  for (unsigned I = 0, E = FT->getNumParams(); I != E; ++I)
+    if (!isCallValueConvertible(CB.getArgOperand(I)->getType(),
+                                FT->getParamType(I), DL))
+      return false;
+  if (CB.getType()->isVoidTy())
+    return true;
+  return !FT->getReturnType()->isVoidTy() &&
+         isCallValueConvertible(FT->getReturnType(), CB.getType(), DL);
+}
+
+// Insert a call of F guarded by the comparison of the called pointer of CB
+// with the references Refs to F before CB, and move CB to the not-taken path.
+// A called pointer loaded from a raised data table holds the address of F in
+// the binary rather than that of the raised function.
+static void promoteCallTarget(CallInst *CB, Function *F,
+                              const CallTargetRefs &Refs) {
+  Instruction *ThenTerm = nullptr;
+  Instruction *ElseTerm = nullptr;
+  IRBuilder<> IRB(CB);
+  Type *AddrTy = IRB.getInt64Ty();
+  std::string Name = ("is_" + F->getName()).str();
+  Value *CalledAddr = IRB.CreatePtrToInt(CB->getCalledOperand(), AddrTy);
+  Value *IsTarget = nullptr;
+  if (Refs.ByAddress.hasValue())
+    IsTarget = IRB.CreateICmpEQ(
+        CalledAddr, ConstantInt::get(AddrTy, *Refs.ByAddress),
+        Refs.ByFunction ? Name + "_addr" : Name);
+  if (Refs.ByFunction) {
+    Value *IsFunction = IRB.CreateICmpEQ(
+        CalledAddr, IRB.CreatePtrToInt(F, AddrTy),
+        IsTarget != nullptr ? Name + "_func" : Name);
+    IsTarget = IsTarget != nullptr ? IRB.CreateOr(IsTarget, IsFunction, Name)
+                                   : IsFunction;
+  }
+  SplitBlockAndInsertIfThenElse(IsTarget, CB, &ThenTerm, &ElseTerm);
+  BasicBlock *TailBB = CB->getParent();
+
+  IRB.SetInsertPoint(ThenTerm);
+  FunctionType *FT = F->getFunctionType();
+  SmallVector<Value *, 8> Args;
+  for (unsigned I = 0, E = FT->getNumParams(); I != E; ++I)
+    Args.push_back(
+        convertCallValue(IRB, CB->getArgOperand(I), FT->getParamType(I)));
+  CallInst *DirectCall = IRB.CreateCall(F, Args);
+  DirectCall->setCallingConv(F->getCallingConv());
+  Value *DirectResult = nullptr;
+  if (!CB->getType()->isVoidTy())
+    DirectResult = convertCallValue(IRB, DirectCall, CB->getType());
+
+  CB->moveBefore(ElseTerm);
+  if (DirectResult != nullptr) {
+    PHINode *Result = PHINode::Create(CB->getType(), 2, "", &TailBB->front());
+    CB->replaceAllUsesWith(Result);
+    Result->addIncoming(DirectResult, ThenTerm->getParent());
+    Result->addIncoming(CB, ElseTerm->getParent());
+  }
+}
+
+bool ModuleRaiser::promoteIndirectCalls() {
+  const DataLayout &DL = M->getDataLayout();
+  SmallVector<CallInst *, 16> IndirectCalls;
+  for (auto MFR : mfRaiserVector)
+    for (Instruction &I : instructions(*MFR->getRaisedFunction()))
+      if (auto *CI = dyn_cast<CallInst>(&I))
+        if (CI->isIndirectCall() && !CI->isMustTailCall())
+          IndirectCalls.push_back(CI);
+
+  bool Changed = false;
+  for (CallInst *CI : IndirectCalls) {
+    CallTargetMap Targets;
+    SmallPtrSet<Value *, 16> Visited;
+    collectCallTargets(CI->getCalledOperand(), *this, Targets, Visited, 0);
+    if (Targets.empty() || Targets.size() > MaxPromotedCallTargets)
+      continue;
+    for (auto &Target : Targets) {
+      Function *F = Target.first;
+      if (!isPromotableCallTarget(*CI, *F, DL))
+        continue;
+      LLVM_DEBUG(dbgs() << "Promoting indirect call in "
+                        << CI->getFunction()->getName() << " to "
+                        << F->getName() << "\n");
+      promoteCallTarget(CI, F, Target.second);
+      Changed = true;
+    }
+  }
+  return Changed;
+}
+
+// Return true if the address of a stack allocation of F may escape F, which
+// would let a callee access the stack frame of F.
+static bool hasEscapingAlloca(Function &F) {
+  for (Instruction &I : instructions(F))
+    if (auto *AI = dyn_cast<AllocaInst>(&I))
+      if (PointerMayBeCaptured(AI, /* ReturnCaptures */ true,
+                               /* StoreCaptures */ true))
+        return true;
+  return false;
+}
+
+// Return true if CI in tail position may be marked musttail, i.e., it calls
+// a function of the prototype and calling convention of its caller and the
+// result is returned unchanged.
+static bool isMustTailCallCandidate(const CallInst &CI, const ReturnInst &Ret) {
+  const Function &Caller = *CI.getFunction();
+  if (CI.getFunctionType() != Caller.getFunctionType() ||
+      CI.getFunctionType()->isVarArg() ||
+      CI.getCallingConv() != Caller.getCallingConv())
+    return false;
+
+  // ABI-impacting parameter attributes must match. Raised functions have
+  // none, so simply require that neither side has any.
+  static const Attribute::AttrKind ABIAttrs[] = {
+      Attribute::StructRet, Attribute::ByVal,      Attribute::InAlloca,
+      Attribute::InReg,     Attribute::SwiftSelf,  Attribute::SwiftError,
+      Attribute::ByRef,     Attribute::Preallocated};
+  for (unsigned I = 0, E = CI.arg_size(); I != E; ++I)
+    for (Attribute::AttrKind Kind : ABIAttrs)
+      if (CI.paramHasAttr(I, Kind) || Caller.hasParamAttribute(I, Kind))
+        return false;
+
+  Value *RetVal = Ret.getReturnValue();
+  if (RetVal == nullptr)
+    return true;
+  if (auto *PN = dyn_cast<PHINode>(RetVal))
+    if (PN->getParent() != CI.getParent())
+      RetVal = PN->getIncomingValueForBlock(CI.getParent());
+  return RetVal == &CI;
+}
+
+// Make CI, in tail position ending at Ret, a musttail call immediately
+// followed by a return of its result.
+static void makeMustTailCall(CallInst *CI, ReturnInst *Ret) {
+  BasicBlock *CallBB = CI->getParent();
+  Instruction *Term = CallBB->getTerminator();
+  if (Term != Ret) {
+    BasicBlock *RetBB = Ret->getParent();
+    RetBB->removePredecessor(CallBB);
+    Term->eraseFromParent();
+    ReturnInst::Create(CI->getContext(),
+                       CI->getType()->isVoidTy() ? nullptr : CI, CallBB);
+    if (pred_empty(RetBB))
+      DeleteDeadBlock(RetBB);
+  }
+  // Delete the now dead casts of the result.
+  for (Instruction *I = CallBB->getTerminator()->getPrevNode(); I != CI;) {
+    Instruction *Prev = I->getPrevNode();
+    assert(I->use_empty() && "Unexpected use of tail call result");
+    I->eraseFromParent();
+    I = Prev;
+  }
+  CI->setTailCallKind(CallInst::TCK_MustTail);
+}
+
+bool ModuleRaiser::markTailCalls() {
+  bool Changed = false;
+  for (auto MFR : mfRaiserVector) {
+    Function *F = MFR->getRaisedFunction();
+    if (F == nullptr || F->isDeclaration() || hasEscapingAlloca(*F))
+      continue;
+
+    SmallVector<std::pair<CallInst *, ReturnInst *>, 4> TailCalls;
+    for (Instruction &I : instructions(*F)) {
+      auto *CI = dyn_cast<CallInst>(&I);
+      if (CI == nullptr || CI->isMustTailCall() || CI->isInlineAsm() ||
+          isa<IntrinsicInst>(CI) || CI->canReturnTwice())
+        continue;
+      if (ReturnInst *Ret = getTailCallReturn(CI))
+        TailCalls.push_back(std::make_pair(CI, Ret));
+    }
+
+    for (auto &TC : TailCalls) {
+      CallInst *CI = TC.first;
+      if (isMustTailCallCandidate(*CI, *TC.second)) {
+        LLVM_DEBUG(dbgs() << "Marking musttail call in " << F->getName()
+                          << "\n");
+        makeMustTailCall(CI, TC.second);
+        Changed = true;
+      } else if (!CI->isTailCall()) {
+        CI->setTailCall();
+        Changed = true;
+      }
+    }
+  }
+  return Changed;
+}
+
+// Build the per-function pipeline that cleans up the stack slots, flag
+// computations and casts of raised code at optimization level OptLevel.
+static FunctionPassManager buildCleanupPipeline(unsigned OptLevel) {
+  FunctionPassManager FPM;
+  FPM.addPass(SROA());
+  FPM.addPass(PromotePass());
+  if (OptLevel >= 2)
+    FPM.addPass(EarlyCSEPass());
+  FPM.addPass(InstCombinePass());
+  if (OptLevel >= 3)
+    FPM.addPass(AggressiveInstCombinePass());
+  FPM.addPass(SimplifyCFGPass());
+  if (OptLevel >= 2) {
+    FPM.addPass(GVN());
+    FPM.addPass(InstCombinePass());
+  }
+  if (OptLevel >= 3)
+    FPM.addPass(ADCEPass());
+  else
+    FPM.addPass(DCEPass());
+  return FPM;
+}
+
+void ModuleRaiser::optimizeRaisedFunctions(unsigned OptLevel,
+                                           raw_ostream &OS) {
+  assert(OptLevel >= 1 && OptLevel <= 3 && "Invalid optimization level");
+  LoopAnalysisManager LAM;
+  FunctionAnalysisManager FAM;
+  CGSCCAnalysisManager CGAM;
+  ModuleAnalysisManager MAM;
+  PassBuilder PB;
+  PB.registerModuleAnalyses(MAM);
+  PB.registerCGSCCAnalyses(CGAM);
+  PB.registerFunctionAnalyses(FAM);
+  PB.registerLoopAnalyses(LAM);
+  PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+  FunctionPassManager FPM = buildCleanupPipeline(OptLevel);
+
+  size_t InstsBefore = 0, InstsAfter = 0;
+  size_t BlocksBefore = 0, BlocksAfter = 0;
+  auto Start = std::chrono::steady_clock::now();
+  // Functions are optimized one at a time, independent of each other.
+  for (auto MFR : mfRaiserVector) {
+    Function *F = MFR->getRaisedFunction();
+    if (F == nullptr || F->isDeclaration())
+      continue;
+    InstsBefore += F->getInstructionCount();
+    BlocksBefore += F->size();
+    FPM.run(*F, FAM);
+    InstsAfter += F->getInstructionCount();
+    BlocksAfter += F->size();
+  }
+  std::chrono::duration<double> Elapsed =
+      std::chrono::steady_clock::now() - Start;
+
+  OS << M->getModuleIdentifier() << ": -O" << OptLevel << ": "
+     << InstsBefore << " -> " << InstsAfter << " instructions, "
+     << BlocksBefore << " -> " << BlocksAfter << " blocks in "
+     << format("%.3f", Elapsed.count()) << "s\n";
+}
@@ -10,12 +10,16 @@
 #define LLVM_TOOLS_LLVM_MCTOLL_MODULERAISER_H
 
 #include "FunctionFilter.h"
+#include "RaisedFunctionCache.h"
+#include "llvm/ADT/MapVector.h"
 #include "llvm/CodeGen/MachineBasicBlock.h"
 #include "llvm/CodeGen/MachineModuleInfo.h"
+#include "llvm/IR/DIBuilder.h"
 #include "llvm/MC/MCDisassembler/MCDisassembler.h"
 #include "llvm/MC/MCInstrAnalysis.h"
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Target/TargetMachine.h"
+#include <memory>
 #include <vector>
 
 using namespace llvm;
@@ -23,6 +27,11 @@ using namespace std;
 
 class MachineFunctionRaiser;
 class MachineInstructionRaiser;
+class MCInstRaiser;
+
+namespace llvm {
+class SHA1;
+} // end namespace llvm
 
 using namespace object;
 
@@ -46,9 +55,12 @@ public:
   ModuleRaiser()
       : M(nullptr), TM(nullptr), MMI(nullptr), MIA(nullptr), MII(nullptr),
         Obj(nullptr), DisAsm(nullptr), TextSectionIndex(-1),
-        Arch(Triple::ArchType::UnknownArch), FFT(nullptr), InfoSet(false) {}
+        Arch(Triple::ArchType::UnknownArch), FFT(nullptr), InfoSet(false),
+        AddrDIFile(nullptr) {}
 
-  static void InitializeAllModuleRaisers();
+  // Create the module raisers of the LLVM target named TargetName, as listed
+  // in Raisers.def. Return false if it has no module raiser.
+  static bool InitializeModuleRaisers(StringRef TargetName);
 
   void setModuleRaiserInfo(Module *M, const TargetMachine *TM,
                            MachineModuleInfo *MMI, const MCInstrAnalysis *MIA,
@@ -105,7 +117,9 @@ public:
   const MCDisassembler *getMCDisassembler() const { return DisAsm; }
   Triple::ArchType getArchType() { return Arch; }
 
-  bool runMachineFunctionPasses();
+  // Raise the machine functions. If ReleaseMachineState is true, free the
+  // machine-level state of each function as soon as it is raised.
+  bool runMachineFunctionPasses(bool ReleaseMachineState = false);
 
   // Return the Function * corresponding to input binary function with
   // start offset equal to that specified as argument. This returns the pointer
@@ -125,17 +139,119 @@ public:
 
   int64_t getTextSectionAddress() const;
 
+  // Record the change of the return type of a raised function. Recorded
+  // changes are applied by applyReturnTypeChanges(). Return true if the
+  // return type the function is raised with changes.
   bool changeRaisedFunctionReturnType(Function *, Type *);
-  virtual ~ModuleRaiser() {
-    if (FFT != nullptr)
-      delete FFT;
-  }
+  // Return the return type raised function F is raised with, i.e., that of
+  // the last recorded change of F, if any.
+  Type *getRaisedFunctionReturnType(Function *F) const;
+  // Recreate each raised function whose return type changed, and each one
+  // that returns the result of a tail call of such a function, once with its
+  // final return type, and rewrite each call of it once. Return true if any
+  // function was changed.
+  bool applyReturnTypeChanges();
+
+  // Replace indirect calls whose possible targets can be determined from the
+  // raised code and data by calls of each target guarded by a comparison of
+  // the called pointer, falling back to the indirect call. Return true if any
+  // call was promoted.
+  bool promoteIndirectCalls();
+
+  // Give raised functions of an executable that are neither exported via the
+  // dynamic symbol table nor address-taken internal linkage and the fast
+  // calling convention. Return true if any function was changed.
+  bool internalizeRaisedFunctions();
+
+  // Prepare the raised module to be linked with those raised from the other
+  // objects of the program. Global values raised from local symbols get
+  // internal linkage, and global variables the object copies from a shared
+  // library via copy relocations become declarations, to be bound to the
+  // definition raised from the library. Return true if the module changed.
+  bool prepareForProgramLink();
+
+  // Mark calls in tail position of raised functions whose stack frame does
+  // not escape as tail calls, and as musttail calls where the callee has the
+  // prototype and calling convention of the caller, so that raised tail jumps
+  // keep running in constant stack. Return true if any call was changed.
+  bool markTailCalls();
+
+  // Run the post-raise cleanup pipeline for optimization level OptLevel
+  // (1 to 3) on each raised function, and report the instruction and block
+  // counts of the raised functions before and after and the time taken to
+  // OS.
+  void optimizeRaisedFunctions(unsigned OptLevel, raw_ostream &OS);
+
+  // Add attributes of known library functions to their declarations, and
+  // derive nounwind, norecurse, readnone/readonly, willreturn and nofree for
+  // the functions defined in the raised module, callees first. Return true if
+  // any attribute was added.
+  bool inferFunctionAttributes();
+
+  // Set the entry count of each raised function to the number of profiled
+  // control transfers to its start address. Return true if any was set.
+  bool setFunctionEntryCounts();
+
+  // Emit line table debug information that records, as line number, the
+  // address of the input binary instruction each raised instruction
+  // originates from. Must be called after setModuleRaiserInfo().
+  void enableAddressDebugInfo();
+  // Return the subprogram of raised function F that starts at address Addr,
+  // creating it if needed. Return nullptr if address debug information is not
+  // enabled.
+  DISubprogram *getOrCreateAddressSubprogram(Function *F, uint64_t Addr) const;
+  // Attach the location of its function start to each raised instruction
+  // without a location and finalize the debug information.
+  void finalizeAddressDebugInfo();
+
+  // Reuse the raised functions recorded in directory Dir for functions whose
+  // instructions, relocations and referenced symbols and data did not change,
+  // and record the other raised functions in it. ToolContext identifies the
+  // build of the tool and the options that affect raising. Must be called
+  // after setModuleRaiserInfo().
+  void enableRaisedFunctionCache(StringRef Dir, StringRef ToolContext);
+
+  // Owned objects may refer to the LLVMContext of the module, so a module
+  // raiser must be deleted while the context is alive.
+  virtual ~ModuleRaiser();
   // Get the function filter for current Module.
   FunctionFilter *getFunctionFilter() const { return FFT; }
   // Get the current architecture type.
   Triple::ArchType getArch() const { return Arch; }
 
 protected:
+  // Return the digest of the parts of the input binary, tool and options that
+  // raised functions may depend on beyond their own instructions.
+  std::string getRaisedFunctionCacheContext() const;
+  // Return the raised function cache key of the function of MFR, given the
+  // digest Context and the names of the functions to be raised by start
+  // offset.
+  std::string getRaisedFunctionCacheKey(
+      MachineFunctionRaiser *MFR, StringRef Context,
+      const DenseMap<uint64_t, StringRef> &FuncNameAt) const;
+  // Return true if cache keys describe the addresses instructions refer to
+  // rather than the layout of the binary.
+  bool symbolizesCacheKeyAddresses() const;
+  // Add to H a description of the address Addr referenced by an instruction
+  // of the function of MCIR that does not depend on the layout of the binary:
+  // the offset into the function, the name of the function starting there or
+  // the dynamic relocation, data symbol or data section holding it. With
+  // FollowStub, a PLT entry at Addr is described by the dynamic relocation it
+  // jumps through. Return false if Addr is not described.
+  bool hashAddressReference(SHA1 &H, uint64_t Addr, const MCInstRaiser *MCIR,
+                            const DenseMap<uint64_t, StringRef> &FuncNameAt,
+                            bool FollowStub) const;
+  // Give the cached global variable GV holding the contents of a data
+  // section those of the section in the binary being raised. Return false if
+  // the section differs in size, or if the cached function F depends on the
+  // start address of the section and the section moved.
+  bool updateRaisedSectionContents(GlobalVariable &GV,
+                                   const Function &F) const;
+  // Make the raised function of MFR the one cached under Key. Return false if
+  // there is no cached function for Key or it does not fit the functions and
+  // global variables of the module.
+  bool loadCachedRaisedFunction(MachineFunctionRaiser *MFR, StringRef Key);
+
   // A sequential list of MachineFunctionRaiser objects created
   // as the instructions of the input binary are parsed. Each of
   // these correspond to a "machine function". A machine function
@@ -146,6 +262,8 @@ protected:
   // A map of raised function pointer to place-holder function pointer
   // that links to the MachineFunction.
   DenseMap<Function *, Function *> PlaceholderRaisedFunctionMap;
+  // Recorded return type changes of raised functions, in recording order.
+  MapVector<Function *, Type *> ReturnTypeChanges;
   // Sorted vector of text relocations
   std::vector<RelocationRef> TextRelocs;
   // Vector of dynamic relocation records
@@ -165,6 +283,12 @@ protected:
   FunctionFilter *FFT;
   // Flag to indicate that fields are set. Resetting is not allowed/expected.
   bool InfoSet;
+  // Builder and file of address debug information, if enabled
+  std::unique_ptr<DIBuilder> AddrDIBuilder;
+  DIFile *AddrDIFile;
+  // Cache of raised functions and the tool context of its keys, if enabled
+  std::unique_ptr<RaisedFunctionCache> FunctionCache;
+  std::string CacheToolContext;
 };
 
 #endif // LLVM_TOOLS_LLVM_MCTOLL_MODULERAISER_H
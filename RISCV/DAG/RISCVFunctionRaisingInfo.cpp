@@ -55,7 +55,6 @@ void RISCVFunctionRaisingInfo::clear() {
   RegValMap.clear();
   ArgValMap.clear();
   NodeRegMap.clear();
-  AllocaMap.clear();
   RetValMap.clear();
 }
 
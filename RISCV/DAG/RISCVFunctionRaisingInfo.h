@@ -36,8 +36,6 @@ public:
   DenseMap<unsigned, Value *> ArgValMap;
   /// Set register for SDNode mapping.
   DenseMap<SDNode *, unsigned> NodeRegMap;
-  /// NZCV mapping.
-  DenseMap<unsigned, Value *> AllocaMap;
   /// Function return IR value mapping with its parent BasicBlock, it is used
   /// to create exit BasicBlock.
   DenseMap<BasicBlock *, Value *> RetValMap;
@@ -24,7 +24,7 @@ RISCVIREmitter::RISCVIREmitter(BasicBlock *bb, RISCVDAGRaisingInfo *dagInfo,
                      RISCVFunctionRaisingInfo *funcInfo)
     : FT(bb->getParent()), BB(bb), CurBB(bb), DAGInfo(dagInfo),
       DAG(&dagInfo->getCurDAG()), CTX(DAG->getContext()), FuncInfo(funcInfo),
-      DLT(funcInfo->DLT), MR(funcInfo->MR), IRB(bb) {}
+      DLT(funcInfo->DLT), MR(funcInfo->MR), IRB(bb), MCIR(nullptr) {}
 
 // Map ISD opcode to Instruction opcode. But some instruction opcode without
 // corresponding ISD opcode mapping.
@@ -129,180 +129,34 @@ Value *RISCVIREmitter::getIRValue(SDValue val) {
   return DAGInfo->getRealValue(N);
 }
 
-static const std::vector<StringRef> CPSR({"N_Flag", "Z_Flag", "C_Flag",
-                                          "V_Flag"});
-
-// Match condition state, make corresponding processing.
-void RISCVIREmitter::emitCondCode(unsigned CondValue, BasicBlock *BB,
-                             BasicBlock *IfBB, BasicBlock *ElseBB) {
-  // switch (CondValue) {
-  // default:
-  //   break;
-  // case RISCV32CC::EQ: { // EQ  Z set
-  //   Value *Z_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[1]);
-  //   Value *InstEQ = IRB.CreateICmpEQ(Z_Flag, IRB.getTrue());
-  //   IRB.CreateCondBr(InstEQ, IfBB, ElseBB);
-  // } break;
-  // case RISCV32CC::NE: { // NE Z clear
-  //   Value *Z_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[1]);
-  //   Value *InstEQ = IRB.CreateICmpEQ(Z_Flag, IRB.getFalse());
-  //   IRB.CreateCondBr(InstEQ, IfBB, ElseBB);
-  // } break;
-  // case RISCV32CC::HS: { // CS  C set
-  //   Value *C_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[2]);
-  //   Value *InstEQ = IRB.CreateICmpEQ(C_Flag, IRB.getTrue());
-  //   IRB.CreateCondBr(InstEQ, IfBB, ElseBB);
-  // } break;
-  // case RISCV32CC::LO: { // CC  C clear
-  //   Value *C_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[2]);
-  //   Value *InstEQ = IRB.CreateICmpEQ(C_Flag, IRB.getFalse());
-  //   IRB.CreateCondBr(InstEQ, IfBB, ElseBB);
-  // } break;
-  // case RISCV32CC::MI: { // MI  N set
-  //   Value *N_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[0]);
-  //   Value *InstEQ = IRB.CreateICmpEQ(N_Flag, IRB.getTrue());
-  //   IRB.CreateCondBr(InstEQ, IfBB, ElseBB);
-  // } break;
-  // case RISCV32CC::PL: { // PL  N clear
-  //   Value *N_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[0]);
-  //   Value *InstEQ = IRB.CreateICmpEQ(N_Flag, IRB.getFalse());
-  //   IRB.CreateCondBr(InstEQ, IfBB, ElseBB);
-  // } break;
-  // case RISCV32CC::VS: { // VS  V set
-  //   Value *V_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[3]);
-  //   Value *InstEQ = IRB.CreateICmpEQ(V_Flag, IRB.getTrue());
-  //   IRB.CreateCondBr(InstEQ, IfBB, ElseBB);
-  // } break;
-  // case RISCV32CC::VC: { // VC  V clear
-  //   Value *V_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[3]);
-  //   Value *InstEQ = IRB.CreateICmpEQ(V_Flag, IRB.getFalse());
-  //   IRB.CreateCondBr(InstEQ, IfBB, ElseBB);
-  // } break;
-  // case RISCV32CC::HI: { // HI  C set & Z clear
-  //   Value *C_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[2]);
-  //   Value *Z_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[1]);
-  //   Value *InstCEQ = IRB.CreateICmpEQ(C_Flag, IRB.getTrue());
-  //   Value *InstZEQ = IRB.CreateICmpEQ(Z_Flag, IRB.getFalse());
-  //   Value *CondPass = IRB.CreateICmpEQ(InstCEQ, InstZEQ);
-  //   IRB.CreateCondBr(CondPass, IfBB, ElseBB);
-  // } break;
-  // case RISCV32CC::LS: { // LS  C clear or Z set
-  //   Value *C_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[2]);
-  //   Value *Z_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[1]);
-  //   Value *InstCEQ = IRB.CreateICmpEQ(C_Flag, IRB.getFalse());
-  //   Value *InstZEQ = IRB.CreateICmpEQ(Z_Flag, IRB.getTrue());
-  //   Value *CondPass = IRB.CreateXor(InstCEQ, InstZEQ);
-  //   IRB.CreateCondBr(CondPass, IfBB, ElseBB);
-  // } break;
-  // case RISCV32CC::GE: { // GE  N = V
-  //   Value *N_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[0]);
-  //   Value *V_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[3]);
-  //   Value *InstEQ = IRB.CreateICmpEQ(N_Flag, V_Flag);
-  //   IRB.CreateCondBr(InstEQ, IfBB, ElseBB);
-  // } break;
-  // case RISCV32CC::LT: { // LT  N != V
-  //   Value *N_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[0]);
-  //   Value *V_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[3]);
-  //   Value *InstNE = IRB.CreateICmpNE(N_Flag, V_Flag);
-  //   IRB.CreateCondBr(InstNE, IfBB, ElseBB);
-  // } break;
-  // case RISCV32CC::GT: { // GT  Z clear & N = V
-  //   Value *N_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[0]);
-  //   Value *Z_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[1]);
-  //   Value *V_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[3]);
-  //   Value *InstZEQ = IRB.CreateICmpEQ(Z_Flag, IRB.getFalse());
-  //   Value *InstNZEQ = IRB.CreateICmpEQ(N_Flag, V_Flag);
-  //   Value *CondPass = IRB.CreateICmpEQ(InstZEQ, InstNZEQ);
-  //   IRB.CreateCondBr(CondPass, IfBB, ElseBB);
-  // } break;
-  // case RISCV32CC::LE: { // LE  Z set or N != V
-  //   Value *N_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[0]);
-  //   Value *Z_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[1]);
-  //   Value *V_Flag = IRB.CreateLoad(FuncInfo->AllocaMap[3]);
-  //   Value *InstZEQ = IRB.CreateICmpEQ(Z_Flag, IRB.getTrue());
-  //   Value *InstNZNE = IRB.CreateICmpNE(N_Flag, V_Flag);
-  //   Value *CondPass = IRB.CreateXor(InstZEQ, InstNZNE);
-  //   IRB.CreateCondBr(CondPass, IfBB, ElseBB);
-  // } break;
-  // case RISCV32CC::AL: { // AL
-  //   assert(false && "Emit conditional code [RISCV32CC::AL]. Should not get here!");
-  // } break;
-  // }
-}
-
-/// Create PHINode for value use selection when running.
-PHINode *RISCVIREmitter::createAndEmitPHINode(SDNode *Node, BasicBlock *BB,
-                                         BasicBlock *IfBB, BasicBlock *ElseBB,
-                                         Instruction *IfInst) {
-  PHINode *phi = PHINode::Create(getDefaultType(), 2, "", ElseBB);
-
-  if (FuncInfo->ArgValMap.count(FuncInfo->NodeRegMap[Node]) > 0) {
-    phi->addIncoming(FuncInfo->ArgValMap[FuncInfo->NodeRegMap[Node]], BB);
-  } else {
-    ConstantInt *zero = ConstantInt::get(getDefaultType(), 0, true);
-    Instruction *ti = BB->getTerminator();
-    Value *p = BinaryOperator::CreateAdd(zero, zero, "", ti);
-    phi->addIncoming(p, BB);
-  }
-
-  phi->addIncoming(IfInst, IfBB);
-  return phi;
-}
-
-/// Update the N Z C V flags of global variable.
-/// Implement AddWithCarry of encoding of instruction.
-/// AddWithCarry(Operand0, Operand1, Flag);
-void RISCVIREmitter::emitCPSR(Value *Operand0, Value *Operand1, BasicBlock *BB, unsigned Flag) {
-  Module &M = *MR->getModule();
-  Type *Ty = IRB.getInt1Ty();
-  Type *OperandTy = getDefaultType();
-  Function *F_Signed = Intrinsic::getDeclaration(&M, Intrinsic::sadd_with_overflow, OperandTy);
-  Function *F_Unsigned = Intrinsic::getDeclaration(&M, Intrinsic::uadd_with_overflow, OperandTy);
-  Value *Args[] = {Operand0, Operand1};
-  Value *Unsigned_Sum;
-  Value *Signed_Sum;
-  if (Flag) {
-    Value *OperandFlag = IRB.CreateAdd(Operand0, IRB.getInt32(1));
-    Value *Args_Flag[] = {Operand1, OperandFlag};
-    Unsigned_Sum = IRB.CreateCall(F_Unsigned, Args_Flag);
-    Signed_Sum = IRB.CreateCall(F_Signed, Args_Flag);
-  } else {
-    Unsigned_Sum = IRB.CreateCall(F_Unsigned, Args);
-    Signed_Sum = IRB.CreateCall(F_Signed, Args);
+// Map the condition code of a SETCC or BR_CC node to the integer compare
+// predicate. RISC-V has no condition flags, so every compare and conditional
+// branch is raised to a single icmp on its source registers.
+static CmpInst::Predicate getICmpPredicate(ISD::CondCode CC) {
+  switch (CC) {
+  default:
+    llvm_unreachable("Unexpected condition code of RISC-V compare!");
+  case ISD::SETEQ:
+    return CmpInst::ICMP_EQ;
+  case ISD::SETNE:
+    return CmpInst::ICMP_NE;
+  case ISD::SETLT:
+    return CmpInst::ICMP_SLT;
+  case ISD::SETGE:
+    return CmpInst::ICMP_SGE;
+  case ISD::SETULT:
+    return CmpInst::ICMP_ULT;
+  case ISD::SETUGE:
+    return CmpInst::ICMP_UGE;
   }
-
-  Value *Sum = ExtractValueInst::Create(Unsigned_Sum, 0, "", BB);
-  Value *Result = Sum;
-  // Update the corresponding flags.
-  // Update N flag.
-  Value *N_Flag = IRB.CreateLShr(Result, IRB.getInt32(31));
-  Value *NTrunc = IRB.CreateTrunc(N_Flag, Ty);
-  IRB.CreateStore(NTrunc, FuncInfo->AllocaMap[0]);
-
-  // Update Z flag.
-  Value *Z_Flag = IRB.CreateICmpEQ(Result, IRB.getInt32(0));
-  Value *ZTrunc = IRB.CreateTrunc(Z_Flag, Ty);
-  IRB.CreateStore(ZTrunc, FuncInfo->AllocaMap[1]);
-
-  // Update C flag.
-  Value *C_Flag = ExtractValueInst::Create(Unsigned_Sum, 1, "", BB);
-  IRB.CreateStore(C_Flag, FuncInfo->AllocaMap[2]);
-
-  // Update V flag.
-  Value *V_Flag = ExtractValueInst::Create(Signed_Sum, 1, "", BB);
-  IRB.CreateStore(V_Flag, FuncInfo->AllocaMap[3]);
 }
 
-void RISCVIREmitter::emitSpecialCPSR(Value *Result, BasicBlock *BB, unsigned Flag) {
-  Type *Ty = IRB.getInt1Ty();
-  // Update N flag.
-  Value *N_Flag = IRB.CreateLShr(Result, IRB.getInt32(31));
-  N_Flag = IRB.CreateTrunc(N_Flag, Ty);
-  IRB.CreateStore(N_Flag, FuncInfo->AllocaMap[0]);
-  // Update Z flag.
-  Value *Z_Flag = IRB.CreateICmpEQ(Result, IRB.getInt32(0));
-
-  IRB.CreateStore(Z_Flag, FuncInfo->AllocaMap[1]);
+/// Emit the i1 value of comparing LHS with RHS under condition code CC.
+Value *RISCVIREmitter::emitICmp(SDValue CC, SDValue LHS, SDValue RHS) {
+  ISD::CondCode Cond = cast<CondCodeSDNode>(CC)->get();
+  Value *S0 = getIRValue(LHS);
+  Value *S1 = getIRValue(RHS);
+  return IRB.CreateICmp(getICmpPredicate(Cond), S0, S1);
 }
 
 Type *RISCVIREmitter::getIntTypeByPtr(Type *pty) {
@@ -325,108 +179,8 @@ Type *RISCVIREmitter::getIntTypeByPtr(Type *pty) {
   return ty;
 }
 
-#define HANDLE_EMIT_CONDCODE_COMMON(OPC)                                       \
-  BasicBlock *IfBB = BasicBlock::Create(*CTX, "", BB->getParent());            \
-  BasicBlock *ElseBB = BasicBlock::Create(*CTX, "", BB->getParent());          \
-                                                                               \
-  emitCondCode(CondValue, BB, IfBB, ElseBB);                                   \
-                                                                               \
-  Value *Inst = BinaryOperator::Create##OPC(S0, S1);                           \
-  IfBB->getInstList().push_back(dyn_cast<Instruction>(Inst));                  \
-  PHINode *Phi = createAndEmitPHINode(Node, BB, IfBB, ElseBB,                  \
-                                      dyn_cast<Instruction>(Inst));            \
-  DAGInfo->setRealValue(Node, Phi);                                            \
-  FuncInfo->ArgValMap[FuncInfo->NodeRegMap[Node]] = Phi;
-
-#define HANDLE_EMIT_CONDCODE(OPC)                                              \
-  HANDLE_EMIT_CONDCODE_COMMON(OPC)                                             \
-                                                                               \
-  IRB.SetInsertPoint(IfBB);                                                    \
-  IRB.CreateBr(ElseBB);                                                        \
-  IRB.SetInsertPoint(ElseBB);
-
-void RISCVIREmitter::emitBinaryCPSR(Value *Inst, BasicBlock *BB, unsigned Opcode,
-                               SDNode *Node) {
-  Value *S0 = getIRValue(Node->getOperand(0));
-  Value *S1 = getIRValue(Node->getOperand(1));
-
-  switch (Opcode) {
-  case Instruction::Add: {
-    emitCPSR(S0, S1, BB, 0);
-  } break;
-  case Instruction::Sub: {
-    Value *InstNot = nullptr;
-    if (ConstantSDNode::classof(Node->getOperand(1).getNode())) {
-      Value *InstTp = IRB.CreateSub(S0, S0);
-      Value *InstAdd = IRB.CreateAdd(InstTp, S1);
-      InstNot = IRB.CreateNot(InstAdd);
-    } else {
-      InstNot = IRB.CreateNot(S1, "");
-    }
-    emitCPSR(S0, InstNot, BB, 1);
-  } break;
-  case Instruction::And: {
-    emitSpecialCPSR(Inst, BB, 0);
-  } break;
-  case Instruction::Mul: {
-    emitSpecialCPSR(Inst, BB, 0);
-  } break;
-  case Instruction::Or: {
-    emitSpecialCPSR(Inst, BB, 0);
-    /* How to deal with C Flag? */
-  } break;
-  case Instruction::Xor: {
-    emitSpecialCPSR(Inst, BB, 0);
-    /* How to deal with C Flag? */
-  } break;
-  case Instruction::Shl: {
-    emitSpecialCPSR(Inst, BB, 0);
-
-    // Update C flag.
-    // extended_x = x : Zeros(shift), c flag = extend_x[N];
-    // c flag = (s0 lsl (s1 -1))[31]
-    Type *Ty = IRB.getInt1Ty();
-    Value *Val = cast<Value>(ConstantInt::get(getDefaultType(), 1, true));
-    Value *C_Flag = IRB.CreateSub(S1, Val);
-    C_Flag = IRB.CreateShl(S0, C_Flag);
-    C_Flag = IRB.CreateLShr(C_Flag, IRB.getInt32(31));
-    Value *CTrunc = IRB.CreateTrunc(C_Flag, Ty);
-
-    IRB.CreateStore(CTrunc, FuncInfo->AllocaMap[2]);
-  } break;
-  case Instruction::LShr: {
-    emitSpecialCPSR(Inst, BB, 0);
-
-    // Update C flag.
-    // c flag = (s0 lsr (s1 -1))[0]
-    Type *Ty = IRB.getInt1Ty();
-    Value *Val = cast<Value>(ConstantInt::get(getDefaultType(), 1, true));
-    Value *C_Flag = IRB.CreateSub(S1, Val);
-    C_Flag = IRB.CreateLShr(S0, C_Flag);
-    C_Flag = IRB.CreateAnd(C_Flag, Val);
-    Value *CTrunc = IRB.CreateTrunc(C_Flag, Ty);
-
-    IRB.CreateStore(CTrunc, FuncInfo->AllocaMap[2]);
-  } break;
-  case Instruction::AShr: {
-    emitSpecialCPSR(Inst, BB, 0);
-
-    // Update C flag.
-    // c flag = (s0 asr (s1 -1))[0]
-    Type *Ty = IRB.getInt1Ty();
-    Value *Val = ConstantInt::get(getDefaultType(), 1, true);
-    Value *C_Flag = IRB.CreateSub(S1, Val);
-    C_Flag = IRB.CreateAShr(S0, C_Flag);
-    C_Flag = IRB.CreateAnd(C_Flag, Val);
-    Value *CTrunc = IRB.CreateTrunc(C_Flag, Ty);
-    IRB.CreateStore(CTrunc, FuncInfo->AllocaMap[2]);
-  } break;
-  }
-}
-
 void RISCVIREmitter::emitBinary(SDNode *Node) {
   unsigned Opc = Node->getOpcode();
-  BasicBlock *BB = getBlock();
   LLVM_DEBUG(dbgs() <<*(DAGInfo->NPMap[Node]->MI) << "\n");
   LLVM_DEBUG(dbgs() << " SDNODE at emit binarynode value: " << Node->getNodeId() << "SDNodeopcodei:"<<Node->getOpcode() << "PersistnentId=" <<Node->PersistentId <<"\n");
   LLVM_DEBUG(dbgs()  << Node->getOperand(0)->PersistentId<< " op000\n");
@@ -441,28 +195,11 @@ void RISCVIREmitter::emitBinary(SDNode *Node) {
   switch (InstOpc) {
 #define HANDLE_BINARY(OPCODE)                                                  \
   case Instruction::OPCODE: {                                                  \
-    if (DAGInfo->NPMap[Node]->HasCPSR) {                                       \
-      unsigned CondValue = DAGInfo->NPMap[Node]->Cond;                         \
-      if (!(DAGInfo->NPMap[Node]->UpdateCPSR)) {                               \
-        HANDLE_EMIT_CONDCODE(OPCODE)                                           \
-      } else if (DAGInfo->NPMap[Node]->Special) {                              \
-        HANDLE_EMIT_CONDCODE_COMMON(OPCODE)                                    \
-        emitBinaryCPSR(Inst, IfBB, InstOpc, Node);                             \
-        IRB.CreateBr(ElseBB);                                                  \
-        IRB.SetInsertPoint(ElseBB);                                            \
-      } else {                                                                 \
-        Value *Inst = IRB.Create##OPCODE(S0, S1);                              \
-        DAGInfo->setRealValue(Node, Inst);                                     \
-        FuncInfo->ArgValMap[FuncInfo->NodeRegMap[Node]] = Inst;                \
-        emitBinaryCPSR(Inst, BB, InstOpc, Node);                               \
-      }                                                                        \
-    } else {                                                                   \
-      Value *Inst = BinaryOperator::Create##OPCODE(S0, S1);                    \
-      BasicBlock *CBB = IRB.GetInsertBlock();                                  \
-      CBB->getInstList().push_back(dyn_cast<Instruction>(Inst));               \
-      DAGInfo->setRealValue(Node, Inst);                                       \
-      FuncInfo->ArgValMap[FuncInfo->NodeRegMap[Node]] = Inst;                  \
-    }                                                                          \
+    Value *Inst = BinaryOperator::Create##OPCODE(S0, S1);                      \
+    BasicBlock *CBB = IRB.GetInsertBlock();                                    \
+    CBB->getInstList().push_back(dyn_cast<Instruction>(Inst));                 \
+    DAGInfo->setRealValue(Node, Inst);                                         \
+    FuncInfo->ArgValMap[FuncInfo->NodeRegMap[Node]] = Inst;                    \
     break;                                                                     \
   }
     HANDLE_BINARY(Add)
@@ -544,48 +281,23 @@ void RISCVIREmitter::emitSDNode(SDNode *Node) {
           S, Node->getValueType(0).getTypeForEVT(*CTX)->getPointerTo());
 
     Value *Inst = nullptr;
-    if (DAGInfo->NPMap[Node]->HasCPSR) {
-      unsigned CondValue = DAGInfo->NPMap[Node]->Cond;
-      // Create new BB for EQ instructin exectute.
-      BasicBlock *IfBB = BasicBlock::Create(*CTX, "", BB->getParent());
-      // Create new BB to update the DAG BB.
-      BasicBlock *ElseBB = BasicBlock::Create(*CTX, "", BB->getParent());
-
-      // Emit the condition code.
-      emitCondCode(CondValue, BB, IfBB, ElseBB);
-      IRB.SetInsertPoint(IfBB);
-      if (GlobalVariable::classof(Ptr))
-        Inst = IRB.CreatePtrToInt(Ptr, getDefaultType());
-      else
-        Inst = IRB.CreateAlignedLoad(
-            Ptr, MaybeAlign(Log2(DLT->getPointerPrefAlignment())));
-
-      PHINode *Phi = createAndEmitPHINode(Node, BB, IfBB, ElseBB,
-                                          dyn_cast<Instruction>(Inst));
-      DAGInfo->setRealValue(Node, Phi);
-      FuncInfo->ArgValMap[FuncInfo->NodeRegMap[Node]] = Phi;
-
-      IRB.CreateBr(ElseBB);
-      IRB.SetInsertPoint(ElseBB);
+    if (GlobalVariable::classof(Ptr)) {
+      // Inst = IRB.CreatePtrToInt(Ptr, getDefaultType());
+      Inst = new PtrToIntInst(Ptr, getDefaultType(), "", BB);
     } else {
-      if (GlobalVariable::classof(Ptr)) {
-        // Inst = IRB.CreatePtrToInt(Ptr, getDefaultType());
-        Inst = new PtrToIntInst(Ptr, getDefaultType(), "", BB);
-      } else {
-        Inst = IRB.CreateAlignedLoad(
-            Ptr, MaybeAlign(Log2(DLT->getPointerPrefAlignment())));
-
-        // TODO:
-        // Temporary method for this.
-        if (Inst->getType() == Type::getInt64Ty(*CTX))
-          Inst = IRB.CreateTrunc(Inst, getDefaultType());
-        else if (Inst->getType() != getDefaultType())
-          Inst = IRB.CreateSExt(Inst, getDefaultType());
-      }
-
-      DAGInfo->setRealValue(Node, Inst);
-      FuncInfo->ArgValMap[FuncInfo->NodeRegMap[Node]] = Inst;
+      Inst = IRB.CreateAlignedLoad(
+          Ptr, MaybeAlign(Log2(DLT->getPointerPrefAlignment())));
+
+      // TODO:
+      // Temporary method for this.
+      if (Inst->getType() == Type::getInt64Ty(*CTX))
+        Inst = IRB.CreateTrunc(Inst, getDefaultType());
+      else if (Inst->getType() != getDefaultType())
+        Inst = IRB.CreateSExt(Inst, getDefaultType());
     }
+
+    DAGInfo->setRealValue(Node, Inst);
+    FuncInfo->ArgValMap[FuncInfo->NodeRegMap[Node]] = Inst;
   } break;
   case Store: {
     LLVM_DEBUG(dbgs()<<"dd\n");
@@ -627,61 +339,16 @@ void RISCVIREmitter::emitSDNode(SDNode *Node) {
       Ptr = IRB.CreateIntToPtr(S, Nty->getPointerTo());
     }
 
-    if (DAGInfo->NPMap[Node]->HasCPSR) {
-      unsigned CondValue = DAGInfo->NPMap[Node]->Cond;
-      // Create new BB for EQ instructin exectute.
-      LLVM_DEBUG(dbgs()<<"\ntag.5\n");
-      BasicBlock *IfBB = BasicBlock::Create(*CTX, "", BB->getParent());
-      // Create new BB to update the DAG BB.
-      BasicBlock *ElseBB = BasicBlock::Create(*CTX, "", BB->getParent());
-
-      // Emit the condition code.
-      emitCondCode(CondValue, BB, IfBB, ElseBB);
-      IRB.SetInsertPoint(IfBB);
-
-      IRB.CreateAlignedStore(Val, Ptr,
-                             MaybeAlign(Log2(DLT->getPointerPrefAlignment())));
-
-      IRB.CreateBr(ElseBB);
-      IRB.SetInsertPoint(ElseBB);
-      LLVM_DEBUG(dbgs()<<"\ntag.6\n");
-    } else {
-      LLVM_DEBUG(dbgs()<<"\ntag.7\n");
-      IRB.CreateAlignedStore(Val, Ptr,
-                             MaybeAlign(Log2(DLT->getPointerPrefAlignment())));
-      LLVM_DEBUG(dbgs()<<"\ntag.8\n");
-    }
+    IRB.CreateAlignedStore(Val, Ptr,
+                           MaybeAlign(Log2(DLT->getPointerPrefAlignment())));
   } break;
   case ICmp: {
-    LLVM_DEBUG(dbgs()<<"ee\n");
-    Value *LHS = getIRValue(Node->getOperand(0));
-    Value *RHS = getIRValue(Node->getOperand(1));
-
-    Value *InstNot = nullptr;
-    if (ConstantSDNode::classof(Node->getOperand(1).getNode())) {
-      Value *InstTp = IRB.CreateSub(LHS, LHS);
-      Value *InstAdd = IRB.CreateAdd(InstTp, RHS);
-      InstNot = IRB.CreateNot(InstAdd);
-    } else {
-      InstNot = IRB.CreateNot(RHS);
-    }
-    emitCPSR(LHS, InstNot, BB, 1);
-  } break;
-  case FCmp: {
-    LLVM_DEBUG(dbgs()<<"ff\n");
-    Value *LHS = getIRValue(Node->getOperand(0));
-    Value *RHS = getIRValue(Node->getOperand(1));
-
-    Value *InstNot = nullptr;
-    if (ConstantSDNode::classof(Node->getOperand(1).getNode())) {
-      Value *InstTp = IRB.CreateSub(LHS, LHS);
-      Value *InstAdd = IRB.CreateAdd(InstTp, RHS);
-      InstNot = IRB.CreateNot(InstAdd);
-    } else {
-      InstNot = IRB.CreateNot(RHS);
-    }
-
-    emitCPSR(LHS, InstNot, BB, 1);
+    // slt, sltu, slti and sltiu set the destination to the compare result.
+    Value *Cmp = emitICmp(Node->getOperand(2), Node->getOperand(0),
+                          Node->getOperand(1));
+    Value *Inst = IRB.CreateZExt(Cmp, getDefaultType());
+    DAGInfo->setRealValue(Node, Inst);
+    FuncInfo->ArgValMap[FuncInfo->NodeRegMap[Node]] = Inst;
   } break;
   }
 }
@@ -728,6 +395,31 @@ void RISCVIREmitter::emitSpecialNode(SDNode *Node) {
   //   }
   //   LLVM_FALLTHROUGH;
   // }
+  case ISD::BR_CC: {
+    // beq, bne, blt, bge, bltu and bgeu branch on the compare of their
+    // source registers. Dest is the offset of the branch target relative to
+    // the branch; the fall through successor is the next block.
+    Value *Cmp = emitICmp(Node->getOperand(1), Node->getOperand(2),
+                          Node->getOperand(3));
+    MachineBasicBlock *MBB = FuncInfo->MBBMap[CurBB];
+    MachineFunction *MF = MBB->getParent();
+    int64_t Dest = cast<ConstantSDNode>(Node->getOperand(4))->getSExtValue();
+    uint64_t TargetOffset = getMCInstIndex(*(DAGInfo->NPMap[Node]->MI)) + Dest;
+    int64_t TargetMBBNo = MCIR->getMBBNumberOfMCInstOffset(TargetOffset, *MF);
+    assert(TargetMBBNo >= 0 && "Branch target is not a block of the function");
+    BasicBlock *IfTrue =
+        FuncInfo->getOrCreateBasicBlock(MF->getBlockNumbered(TargetMBBNo));
+
+    auto NextMBBIter = std::next(MBB->getIterator());
+    // Falling off the end of the function is undefined, so a conditional
+    // branch in the last block always branches to its target.
+    if (NextMBBIter == MF->end()) {
+      IRB.CreateBr(IfTrue);
+      break;
+    }
+    BasicBlock *NextBB = FuncInfo->getOrCreateBasicBlock(&*NextMBBIter);
+    IRB.CreateCondBr(Cmp, IfTrue, NextBB);
+  } break;
   case EXT_RISCV32ISD::BRD: {
     // Get the function call Index.
 
@@ -820,59 +512,25 @@ void RISCVIREmitter::emitSpecialNode(SDNode *Node) {
   //   unsigned NumDests = Node->getNumOperands();
   //   IRB.CreateIndirectBr(Func, NumDests);
   // } break;
-  // case ISD::BR_JT: {
-  //   // Emit the switch instruction.
-  //   if (jtList.size() > 0) {
-  //     MachineBasicBlock *mbb = FuncInfo->MBBMap[CurBB];
-  //     MachineFunction *MF = mbb->getParent();
-
-  //     std::vector<JumpTableBlock> JTCases;
-  //     const MachineJumpTableInfo *MJT = MF->getJumpTableInfo();
-  //     unsigned jtIndex = Node->getConstantOperandVal(0);
-  //     std::vector<MachineJumpTableEntry> JumpTables = MJT->getJumpTables();
-  //     for (unsigned j = 0, f = JumpTables[jtIndex].MBBs.size(); j != f; ++j) {
-  //       llvm::Type *i32_type = llvm::IntegerType::getInt32Ty(*CTX);
-  //       llvm::ConstantInt *i32_val =
-  //           cast<ConstantInt>(llvm::ConstantInt::get(i32_type, j, true));
-  //       MachineBasicBlock *Succ = JumpTables[jtIndex].MBBs[j];
-  //       ConstantInt *CaseVal = i32_val;
-  //       JTCases.push_back(std::make_pair(CaseVal, Succ));
-  //     }
-  //     // main->getEntryBlock().setName("entry");
-
-  //     unsigned int numCases = JTCases.size();
-  //     BasicBlock *def_bb =
-  //         FuncInfo->getOrCreateBasicBlock(jtList[jtIndex].df_MBB);
-
-  //     BasicBlock *cd_bb =
-  //         FuncInfo->getOrCreateBasicBlock(jtList[jtIndex].conditionMBB);
-
-  //     // conditon instruction
-  //     Instruction *cdi = nullptr;
-  //     for (BasicBlock::iterator DI = cd_bb->begin(); DI != cd_bb->end(); DI++) {
-  //       Instruction *ins = dyn_cast<Instruction>(DI);
-  //       if (isa<LoadInst>(DI) && !cdi) {
-  //         cdi = ins;
-  //       }
-
-  //       if (cdi && (ins->getOpcode() == Instruction::Sub)) {
-  //         if (isa<ConstantInt>(ins->getOperand(1))) {
-  //           ConstantInt *opr = dyn_cast<ConstantInt>(ins->getOperand(1));
-  //           if (opr->uge(0)) {
-  //             cdi = ins;
-  //           }
-  //         }
-  //       }
-  //     }
-
-  //     SwitchInst *Inst = IRB.CreateSwitch(cdi, def_bb, numCases);
-  //     for (unsigned i = 0, e = numCases; i != e; ++i) {
-  //       BasicBlock *case_bb =
-  //           FuncInfo->getOrCreateBasicBlock(JTCases[i].second);
-  //       Inst->addCase(JTCases[i].first, case_bb);
-  //     }
-  //   }
-  // } break;
+  case ISD::BR_JT: {
+    // Emit the switch on the table index. Out of range indices are branched
+    // to the default block by the bounds check in the condition block.
+    MachineBasicBlock *MBB = FuncInfo->MBBMap[CurBB];
+    MachineFunction *MF = MBB->getParent();
+    const MachineJumpTableInfo *MJT = MF->getJumpTableInfo();
+    unsigned JTIndex = Node->getConstantOperandVal(0);
+    const std::vector<MachineBasicBlock *> &JTMBBs =
+        MJT->getJumpTables()[JTIndex].MBBs;
+    Value *Index = getIRValue(Node->getOperand(1));
+
+    BasicBlock *DefaultBB =
+        FuncInfo->getOrCreateBasicBlock(jtList[JTIndex].df_MBB);
+    SwitchInst *Inst = IRB.CreateSwitch(Index, DefaultBB, JTMBBs.size());
+    for (unsigned I = 0, E = JTMBBs.size(); I != E; ++I)
+      Inst->addCase(
+          cast<ConstantInt>(ConstantInt::get(Index->getType(), I)),
+          FuncInfo->getOrCreateBasicBlock(JTMBBs[I]));
+  } break;
   // case ISD::ROTR: {
   //   Value *S0 = getIRValue(Node->getOperand(0));
   //   Value *S1 = getIRValue(Node->getOperand(1));
@@ -16,6 +16,7 @@
 
 #include "RISCVDAGRaisingInfo.h"
 #include "RISCVFunctionRaisingInfo.h"
+#include "MCInstRaiser.h"
 #include "ModuleRaiser.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/IR/IRBuilder.h"
@@ -35,6 +36,7 @@ class RISCVIREmitter {
   IRBuilder<> IRB;
 
   std::vector<JumpTableInfo> jtList;
+  MCInstRaiser *MCIR;
 
 public:
   RISCVIREmitter(BasicBlock *bb, RISCVDAGRaisingInfo *dagInfo,
@@ -55,6 +57,7 @@ public:
     jtList = List;
     return true;
   }
+  void setMCInstRaiser(MCInstRaiser *PMCIR) { MCIR = PMCIR; }
 
 private:
   /// Generate SDNode code for a target-independent node.
@@ -63,17 +66,8 @@ private:
   /// Emit SDNodes of binary operations.
   void emitBinary(SDNode *Node);
   void emitSpecialNode(SDNode *Node);
-  void emitCondCode(unsigned CondValue, BasicBlock *BB, BasicBlock *IfBB,
-                    BasicBlock *ElseBB);
-  void emitBinaryCPSR(Value *Inst, BasicBlock *BB, unsigned Opcode,
-                      SDNode *Node);
-  /// Update the N Z C V flags of global variable.
-  void emitCPSR(Value *Operand0, Value *Operand1, BasicBlock *BB,
-                unsigned Flag);
-  void emitSpecialCPSR(Value *Result, BasicBlock *BB, unsigned Flag);
-  /// Create PHINode for value use selection when running.
-  PHINode *createAndEmitPHINode(SDNode *Node, BasicBlock *BB, BasicBlock *IfBB,
-                                BasicBlock *ElseBB, Instruction *IfInst);
+  /// Emit the i1 compare of LHS and RHS under the condition code node CC.
+  Value *emitICmp(SDValue CC, SDValue LHS, SDValue RHS);
   IntegerType *getDefaultType() {
     return Type::getIntNTy(*CTX, DLT->getPointerSizeInBits());
   }
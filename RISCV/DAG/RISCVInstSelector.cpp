@@ -86,6 +86,18 @@ SDValue RISCVInstSelector::getMDOperand(SDNode *N) {
   return SDValue();
 }
 
+/// Get the value read from a source operand, the hardwired zero register
+/// reads as constant 0.
+SDValue RISCVInstSelector::getSourceValue(SDValue Op, const SDLoc &dl) {
+  if (!RegisterSDNode::classof(Op.getNode()))
+    return Op;
+
+  if (static_cast<RegisterSDNode *>(Op.getNode())->getReg() == RISCV::X0)
+    return CurDAG->getConstant(0, dl, getDefaultEVT());
+
+  return FuncInfo->getValFromRegMap(Op);
+}
+
 /// Instruction opcode selection.
 void RISCVInstSelector::selectCode(SDNode *N) {
   SDLoc dl(N);
@@ -261,7 +273,11 @@ void RISCVInstSelector::selectCode(SDNode *N) {
     SDValue Func = N->getOperand(1);
     SDValue LinkReg = N->getOperand(0);
     RegisterSDNode* LinkRegPtr = static_cast<RegisterSDNode*>(LinkReg.getNode());
-    assert(LinkRegPtr->getReg() == RISCV::X1 && "JAL Link ret Addr not eq to X1, case uncovered!\n");
+    // j <func>, i.e., jal x0, <func>, leaving the function is a tail call.
+    assert((LinkRegPtr->getReg() == RISCV::X1 ||
+            (LinkRegPtr->getReg() == RISCV::X0 &&
+             DAGInfo->NPMap[N]->MI->getParent()->succ_empty())) &&
+           "JAL Link ret Addr not eq to X1, case uncovered!\n");
     LLVM_DEBUG(Func.getNode()->dump());
     SDNode *Node = nullptr;
     /*
@@ -284,6 +300,68 @@ void RISCVInstSelector::selectCode(SDNode *N) {
     FuncInfo->NodeRegMap[Node] = RISCV::X10;
     replaceNode(N, Node);
   } break;
+  /* SLT */
+  case RISCV::SLT:
+  case RISCV::SLTI:
+  case RISCV::SLTU:
+  case RISCV::SLTIU: {
+    SDValue Rd = N->getOperand(0);
+    SDValue Rs1 = getSourceValue(N->getOperand(1), dl);
+    SDValue Rs2 = getSourceValue(N->getOperand(2), dl);
+    unsigned Opc = N->getMachineOpcode();
+    ISD::CondCode CC = (Opc == RISCV::SLTU || Opc == RISCV::SLTIU)
+                           ? ISD::SETULT
+                           : ISD::SETLT;
+    SDNode *Node = CurDAG
+                       ->getNode(ISD::SETCC, dl, getDefaultEVT(), Rs1, Rs2,
+                                 CurDAG->getCondCode(CC))
+                       .getNode();
+    recordDefinition(Rd.getNode(), Node);
+    replaceNode(N, Node);
+  } break;
+  /* Bcc */
+  case RISCV::BEQ:
+  case RISCV::BNE:
+  case RISCV::BLT:
+  case RISCV::BGE:
+  case RISCV::BLTU:
+  case RISCV::BGEU: {
+    SDValue Rs1 = getSourceValue(N->getOperand(0), dl);
+    SDValue Rs2 = getSourceValue(N->getOperand(1), dl);
+    SDValue Dest = N->getOperand(2);
+    ISD::CondCode CC = ISD::SETEQ;
+    switch (N->getMachineOpcode()) {
+    case RISCV::BNE:
+      CC = ISD::SETNE;
+      break;
+    case RISCV::BLT:
+      CC = ISD::SETLT;
+      break;
+    case RISCV::BGE:
+      CC = ISD::SETGE;
+      break;
+    case RISCV::BLTU:
+      CC = ISD::SETULT;
+      break;
+    case RISCV::BGEU:
+      CC = ISD::SETUGE;
+      break;
+    }
+    SDValue Ops[] = {CurDAG->getEntryNode(), CurDAG->getCondCode(CC), Rs1,
+                     Rs2, Dest};
+    SDNode *Node = CurDAG->getNode(ISD::BR_CC, dl, MVT::Other, Ops).getNode();
+    replaceNode(N, Node);
+  } break;
+  /* Jump table dispatch built by RISCV32CreateJumpTable */
+  case RISCV::PseudoBRIND: {
+    SDValue JTIndex = N->getOperand(0);
+    SDValue Index = getSourceValue(N->getOperand(1), dl);
+    SDNode *Node = CurDAG
+                       ->getNode(ISD::BR_JT, dl, getDefaultEVT(), JTIndex,
+                                 Index, getMDOperand(N))
+                       .getNode();
+    replaceNode(N, Node);
+  } break;
 
   /* ADC */
   // case RISCV32::ADCrr:
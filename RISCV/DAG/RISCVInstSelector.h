@@ -51,6 +51,9 @@ private:
   bool isArgumentNode(SDNode *node);
   /// Checks the SDNode is a function return or not.
   bool isReturnNode(SDNode *node);
+  /// Get the value read from a source operand, the hardwired zero register
+  /// reads as constant 0.
+  SDValue getSourceValue(SDValue Op, const SDLoc &dl);
   /// Instruction opcode selection.
   void selectCode(SDNode *N);
   EVT getDefaultEVT() { return EVT::getEVT(FuncInfo->getDefaultType()); }
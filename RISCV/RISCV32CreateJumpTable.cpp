@@ -28,6 +28,7 @@
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/Object/ELFObjectFile.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
 
 #define DEBUG_TYPE "mctoll"
@@ -115,220 +116,286 @@ bool RISCV32CreateJumpTable::UpdatetheBranchInst(MachineBasicBlock &MBB) {
   return true;
 }
 
-/// Raise the machine jumptable according to the CFG.
-bool RISCV32CreateJumpTable::raiseMaichineJumpTable(MachineFunction &MF) {
-  // // A vector to record MBBs that need to be erased upon jump table creation.
-  // std::vector<MachineBasicBlock *> MBBsToBeErased;
-
-  // std::map<uint64_t, MCInstOrData> mcInstMapData;
-  // MCInstRaiser::const_mcinst_iter iter_in;
-
-  // // Save the ADDri and Calculate the start address of data.
-  // for (MachineBasicBlock &JmpTblBaseCalcMBB : MF) {
-  //   for (MachineBasicBlock::iterator CurMBBIter = JmpTblBaseCalcMBB.begin();
-  //        CurMBBIter != JmpTblBaseCalcMBB.end(); CurMBBIter++) {
-  //     MachineInstr &JmpTblOffsetCalcMI = *CurMBBIter;
-  //     // Find the MI: %r0 = ADDri %pc, #8
-  //     // add     r0, pc, #8
-  //     // ldr     r1, [sp]
-  //     // ldr     r2, [r0, r1, lsl #2]
-  //     // add     pc, r0, r2
-
-  //     To do: For arm, only find jump table when "add   r0, pc", #imm pattern exists, what is the pattern mean? in which case this pattern appears?
-  //            and how to modify it for risc-v ? 
-
-  //     if (JmpTblOffsetCalcMI.getOpcode() == RISCV32::ADDri &&
-  //         JmpTblOffsetCalcMI.getOperand(1).getReg() == RISCV32::PC &&
-  //         JmpTblOffsetCalcMI.getOperand(2).getImm() == 8) {
-  //       // If the fourth instruction in swith block is "add pc, rm, rn",
-  //       // this library should be built with "-fPIC".
-  //       bool IsFPIC = false;
-  //       MachineBasicBlock::iterator FourthInstr = CurMBBIter;
-  //       std::advance(FourthInstr, 3);
-  //       if (FourthInstr != JmpTblBaseCalcMBB.end()) {
-  //         MachineInstr &JGPC = *FourthInstr;
-  //         if (JGPC.getOpcode() == RISCV32::ADDrr &&
-  //             JGPC.getOperand(0).getReg() == RISCV32::PC) {
-  //           IsFPIC = true;
-  //         }
-  //       }
-
-  //       // A vector of switch target MBBs
-  //       std::vector<MachineBasicBlock *> JmpTgtMBBvec;
-  //       assert(
-  //           MCIR != nullptr &&
-  //           "Current function machine instruction raiser wasn't initialized!");
-  //       for (iter_in = MCIR->const_mcinstr_begin();
-  //            iter_in != MCIR->const_mcinstr_end(); iter_in++) {
-  //         MCInstOrData mcInstorData = iter_in->second;
-  //         if (mcInstorData.isData() && mcInstorData.getData() > 0) {
-  //           // The 16 is 8 + 8. The first 8 is the PC offset, the second 8 is
-  //           // the immediate of current instruction.
-  //           // If the current library is position-independent, the offset should
-  //           // be CASE VALUE + PC + 8.
-  //           // If the current library is not position-independent, the offset
-  //           // should be CASE VALUE - text section address.
-  //           uint64_t Offset =
-  //               IsFPIC ? (mcInstorData.getData() +
-  //                         MCIR->getMCInstIndex(JmpTblOffsetCalcMI) + 16)
-  //                      : (mcInstorData.getData() - MR->getTextSectionAddress());
-  //           auto MBBNo = MCIR->getMBBNumberOfMCInstOffset(Offset, MF);
-  //           if (MBBNo != -1) {
-  //             MachineBasicBlock *MBB = MF.getBlockNumbered(MBBNo);
-  //             JmpTgtMBBvec.push_back(MBB);
-  //           }
-  //         }
-  //       }
-
-  //       // If no potential jump target addresses were found the current
-  //       // instruction does not compute jump table base.
-  //       if (JmpTgtMBBvec.size() == 0) {
-  //         continue;
-  //       }
-  //       // Construct jump table. Current block is the block which would
-  //       // potentially contain the start of jump targets. If current block has
-  //       // multiple predecessors this may not be a jump table. For now assert
-  //       // this to discover potential situations in binaries. Change the assert
-  //       // to and continue if the assumption is correct.
-  //       assert((JmpTblBaseCalcMBB.pred_size() == 1) &&
-  //              "Expect a single predecessor during jump table discovery");
-  //       MachineBasicBlock *JmpTblPredMBB = *(JmpTblBaseCalcMBB.pred_begin());
-  //       // Predecessor block of current block (MBB) - which is jump table block
-  //       // - is expected to have exactly two successors; one the current block
-  //       // and the other which should become the default MBB for the switch.
-  //       assert((JmpTblPredMBB->succ_size() == 2) &&
-  //              "Unexpected number of successors of switch block");
-  //       JumpTableInfo JmpTblInfo;
-  //       // Set predecessor of current block as condition block of jump table
-  //       // info
-  //       JmpTblInfo.conditionMBB = JmpTblPredMBB;
-  //       // Set default basic block in jump table info
-  //       for (auto Succ : JmpTblPredMBB->successors()) {
-  //         if (Succ != &JmpTblBaseCalcMBB) {
-  //           JmpTblInfo.df_MBB = Succ;
-  //           break;
-  //         }
-  //       }
-  //       MachineJumpTableInfo *JTI =
-  //           MF.getOrCreateJumpTableInfo(llvm::MachineJumpTableInfo::EK_Inline);
-  //       JmpTblInfo.jtIdx = JTI->createJumpTableIndex(JmpTgtMBBvec);
-  //       // Verify the branch instruction of JmpTblPredMBB is a conditional jmp
-  //       // that uses eflags. Go to the most recent instruction that defines
-  //       // eflags. Remove that instruction as well as any subsequent instruction
-  //       // that uses the register defined by that instruction.
-  //       MachineInstr &BranchInstr = JmpTblPredMBB->instr_back();
-  //       std::vector<MachineInstr *> MBBInstrsToErase;
-  //       if (BranchInstr.isConditionalBranch()) {
-  //         // Walk the basic block backwards to find the most recent instruction
-  //         // that implicitly defines eflags.
-  //         bool EflagsModifierFound = false;
-  //         MachineBasicBlock::reverse_instr_iterator CurInstrIter =
-  //             JmpTblPredMBB->instr_rbegin();
-  //         for (auto LastInstIter = JmpTblPredMBB->instr_rend();
-  //              ((CurInstrIter != LastInstIter) && (!EflagsModifierFound));
-  //              ++CurInstrIter) {
-  //           MachineInstr &curInst = *CurInstrIter;
-  //           if (curInst.getDesc().hasImplicitDefOfPhysReg(RISCV32::CPSR)) {
-  //             EflagsModifierFound = true;
-  //           }
-  //         }
-  //         assert(EflagsModifierFound &&
-  //                "Failed to find eflags defining instruction during jump table "
-  //                "extraction.");
-  //         // Note: decrement CurInstrIter to point to the eflags modifying
-  //         // instruction.
-  //         CurInstrIter--;
-  //         // Find the registers that the eflags modifying instruction defines.
-  //         // Delete all instructions that uses them since we will be deleting
-  //         // the eflags modifying instruction.
-  //         MachineInstr &EflagsModInstr = *CurInstrIter;
-  //         std::set<unsigned int> EflagsDefRegs;
-  //         for (auto MO : EflagsModInstr.defs()) {
-  //           // Create a set of all physical registers this instruction defines.
-  //           if (MO.isReg()) {
-  //             unsigned int DefReg = MO.getReg();
-  //             if (Register::isPhysicalRegister(DefReg)) {
-  //               EflagsDefRegs.insert(getRISCV32CPSR(DefReg));
-  //             }
-  //           }
-  //         }
-  //         // Add EflagsModInstr to the list of instructions to delete
-  //         MBBInstrsToErase.push_back(&EflagsModInstr);
-
-  //         MachineBasicBlock::iterator InstrEndIter = JmpTblPredMBB->instr_end();
-  //         // Start walking the block instructions forward to identify
-  //         // instructions that need be deleted.
-  //         MachineBasicBlock::iterator InstrFwdIter =
-  //             MachineBasicBlock::instr_iterator(CurInstrIter);
-  //         // Find instructions that use any of the register in the set
-  //         // EflagsDefRegs. Add it to a list of instructions that can be
-  //         // deleted.
-  //         while (InstrFwdIter != InstrEndIter) {
-  //           MachineInstr &CurInstr = *InstrFwdIter;
-  //           for (auto MO : CurInstr.uses()) {
-  //             // Check if this use register is defined by EflagsModInstr
-  //             if (MO.isReg()) {
-  //               unsigned int UseReg = MO.getReg();
-  //               if (Register::isPhysicalRegister(UseReg)) {
-  //                 if (EflagsDefRegs.find(getRISCV32CPSR(UseReg)) !=
-  //                     EflagsDefRegs.end()) {
-  //                   MBBInstrsToErase.push_back(&CurInstr);
-  //                   // No need to look for other register uses.
-  //                   break;
-  //                 }
-  //               }
-  //             }
-  //           }
-  //           // If this instruction redefines any of the registers, remove that
-  //           // register from EflagsDefRegs. Any instruction that uses this
-  //           // redefined register and follows the current instruction, should
-  //           // not be deleted.
-  //           for (auto MO : CurInstr.defs()) {
-  //             if (MO.isReg()) {
-  //               unsigned int DefReg = MO.getReg();
-  //               if (Register::isPhysicalRegister(DefReg)) {
-  //                 if (EflagsDefRegs.find(getRISCV32CPSR(DefReg)) !=
-  //                     EflagsDefRegs.end()) {
-  //                   EflagsDefRegs.erase(DefReg);
-  //                 }
-  //               }
-  //             }
-  //           }
-  //           InstrFwdIter++;
-  //         }
-  //         // Finally add BranchInstr to the list of instructions to be
-  //         // deleted
-  //         MBBInstrsToErase.push_back(&BranchInstr);
-  //         // BranchInstr.dump();
-  //         // Now delete the instructions
-  //         for (auto MI : MBBInstrsToErase) {
-  //           JmpTblPredMBB->erase(MI);
-  //         }
-  //       }
-
-  //       const RISCV32Subtarget &STI = MF.getSubtarget<RISCV32Subtarget>();
-  //       const RISCV32BaseInstrInfo *TII = STI.getInstrInfo();
-  //       MBBsToBeErased.push_back(&JmpTblBaseCalcMBB);
-  //       MachineInstrBuilder MIB =
-  //           BuildMI(JmpTblPredMBB, DebugLoc(), TII->get(RISCV32::BR_JTr))
-  //               .addJumpTableIndex(JmpTblInfo.jtIdx);
-
-  //       // The new machine instrucion should contain the metadata.
-  //       // Create the metadata and add it to the machine instrucion.
-  //       LLVMContext *CTX = &M->getContext();
-  //       ConstantAsMetadata *CAM = ConstantAsMetadata::get(
-  //           ConstantInt::get(*CTX, llvm::APInt(64, 0, false)));
-  //       MDNode *MDnode = MDNode::get(*CTX, CAM);
-  //       MIB.addMetadata(MDnode);
-  //       jtList.push_back(JmpTblInfo);
-  //     }
-  //   }
-  // }
+/// Get the closest instruction preceding MI in its block that defines Reg.
+MachineInstr *RISCV32CreateJumpTable::getPrecedingDef(MachineInstr &MI,
+                                                      unsigned Reg) {
+  MachineBasicBlock *MBB = MI.getParent();
+  for (auto Iter = std::next(MI.getReverseIterator()), End = MBB->rend();
+       Iter != End; ++Iter)
+    if (Iter->definesRegister(Reg))
+      return &*Iter;
+  return nullptr;
+}
 
-  // // Delete MBBs
-  // for (auto MBB : MBBsToBeErased) {
-  //   MBB->eraseFromParent();
-  // }
+/// Return true if Reg is read by an instruction in [I, E) that is not in
+/// Erased before Reg is redefined. IsRedefined is set if Reg is redefined in
+/// the range.
+static bool isReadBeforeDef(MachineBasicBlock::iterator I,
+                            MachineBasicBlock::iterator E, unsigned Reg,
+                            const SmallPtrSetImpl<MachineInstr *> &Erased,
+                            bool &IsRedefined) {
+  IsRedefined = false;
+  for (; I != E; ++I) {
+    if (Erased.count(&*I))
+      continue;
+    if (I->readsRegister(Reg))
+      return true;
+    if (I->definesRegister(Reg)) {
+      IsRedefined = true;
+      return false;
+    }
+  }
+  return false;
+}
+
+/// Return true if the register defined by MI is read by no instruction other
+/// than those in Erased, in the block of MI or in its successors Succs.
+/// Liveness is not tracked beyond the successors, so a register that is not
+/// redefined in a successor is assumed to be read.
+bool RISCV32CreateJumpTable::isDeadDef(
+    MachineInstr &MI, const std::vector<MachineBasicBlock *> &Succs,
+    const SmallPtrSetImpl<MachineInstr *> &Erased) {
+  unsigned Reg = MI.getOperand(0).getReg();
+  MachineBasicBlock *MBB = MI.getParent();
+  bool IsRedefined = false;
+  if (isReadBeforeDef(std::next(MI.getIterator()), MBB->end(), Reg, Erased,
+                      IsRedefined))
+    return false;
+  if (IsRedefined)
+    return true;
+  for (MachineBasicBlock *Succ : Succs)
+    if (isReadBeforeDef(Succ->begin(), Succ->end(), Reg, Erased,
+                        IsRedefined) ||
+        !IsRedefined)
+      return false;
+  return true;
+}
+
+/// Get the number of entries of the jump table indexed by IdxReg from the
+/// bounds check that ends PredMBB. The check branches to the default block
+/// if the index is out of range:
+///   li    a1, 4
+///   bltu  a1, a0, .LBB_default
+bool RISCV32CreateJumpTable::getJumpTableBound(MachineBasicBlock *PredMBB,
+                                               unsigned IdxReg,
+                                               uint64_t &NumEntries) {
+  if (PredMBB->empty())
+    return false;
+  MachineInstr &BranchMI = PredMBB->back();
+  unsigned Opc = BranchMI.getOpcode();
+  if (Opc != RISCV::BLTU && Opc != RISCV::BGEU)
+    return false;
+  // bltu bound, idx is taken for idx > bound; bgeu idx, bound is taken for
+  // idx >= bound.
+  unsigned BoundOpIdx = (Opc == RISCV::BLTU) ? 0 : 1;
+  unsigned IdxOpIdx = 1 - BoundOpIdx;
+  if (BranchMI.getOperand(IdxOpIdx).getReg() != IdxReg)
+    return false;
+  MachineInstr *BoundMI =
+      getPrecedingDef(BranchMI, BranchMI.getOperand(BoundOpIdx).getReg());
+  if (BoundMI == nullptr || BoundMI->getOpcode() != RISCV::ADDI ||
+      BoundMI->getOperand(1).getReg() != RISCV::X0)
+    return false;
+  int64_t Bound = BoundMI->getOperand(2).getImm();
+  if (Bound < 0)
+    return false;
+  NumEntries = (Opc == RISCV::BLTU) ? Bound + 1 : Bound;
+  return NumEntries != 0;
+}
+
+/// Read NumEntries 32-bit entries of the jump table at TableAddr. Entries are
+/// either absolute addresses or, in position independent code, offsets from
+/// the table address.
+bool RISCV32CreateJumpTable::readJumpTableTargets(
+    uint64_t TableAddr, uint64_t NumEntries, bool IsRelative,
+    std::vector<MachineBasicBlock *> &Targets) {
+  const ObjectFile *Obj = MR->getObjectFile();
+  int64_t TextSectionAddress = MR->getTextSectionAddress();
+  for (const SectionRef &Sec : Obj->sections()) {
+    uint64_t SecStart = Sec.getAddress();
+    uint64_t SecEnd = SecStart + Sec.getSize();
+    if (TableAddr < SecStart || TableAddr + NumEntries * 4 > SecEnd)
+      continue;
+    if (Sec.isBSS() || Sec.isText())
+      return false;
+    Expected<StringRef> ContentsOrErr = Sec.getContents();
+    if (!ContentsOrErr) {
+      consumeError(ContentsOrErr.takeError());
+      return false;
+    }
+    const uint8_t *Entries =
+        ContentsOrErr->bytes_begin() + (TableAddr - SecStart);
+    for (uint64_t I = 0; I < NumEntries; I++) {
+      uint32_t Entry = support::endian::read32le(Entries + I * 4);
+      uint64_t TargetAddr =
+          IsRelative ? TableAddr + static_cast<int32_t>(Entry) : Entry;
+      // Each target needs to start a block of this function.
+      uint64_t Offset = TargetAddr - TextSectionAddress;
+      int64_t MBBNo = MCIR->getMBBNumberOfMCInstOffset(Offset, *MF);
+      if (MBBNo == -1 ||
+          MCIR->getMCInstOffsetOfMBBNumber(MBBNo) != (int64_t)Offset)
+        return false;
+      Targets.push_back(MF->getBlockNumbered(MBBNo));
+    }
+    return true;
+  }
+  return false;
+}
+
+/// Raise the machine jumptable according to the CFG. The jump table dispatch
+/// sequence
+///   slli  a0, a0, 2
+///   lui   a1, %hi(.LJTI0_0)            (auipc a1, %pcrel_hi(.LJTI0_0))
+///   addi  a1, a1, %lo(.LJTI0_0)        (addi a1, a1, %pcrel_lo(...))
+///   add   a0, a0, a1
+///   lw    a0, 0(a0)
+///   add   a0, a0, a1                   (position independent code only)
+///   jr    a0
+/// is replaced by a PseudoBRIND with the jump table index and the table index
+/// register a0, which is selected to a switch.
+bool RISCV32CreateJumpTable::raiseMaichineJumpTable(MachineFunction &MF) {
+  const TargetInstrInfo *TII = MF.getSubtarget().getInstrInfo();
+  int64_t TextSectionAddress = MR->getTextSectionAddress();
+
+  for (MachineBasicBlock &MBB : MF) {
+    if (MBB.empty())
+      continue;
+    MachineInstr &JmpMI = MBB.back();
+    // jr rs is jalr x0, 0(rs); jr ra is a return.
+    if (JmpMI.getOpcode() != RISCV::JALR ||
+        JmpMI.getOperand(0).getReg() != RISCV::X0 ||
+        JmpMI.getOperand(1).getReg() == RISCV::X1 ||
+        JmpMI.getOperand(2).getImm() != 0)
+      continue;
+
+    std::vector<MachineInstr *> MBBInstrsToErase;
+    MachineInstr *TgtDefMI =
+        getPrecedingDef(JmpMI, JmpMI.getOperand(1).getReg());
+    if (TgtDefMI == nullptr)
+      continue;
+
+    // Find the load of the table entry. In position independent code, the
+    // loaded offset is added to the table address.
+    MachineInstr *LoadMI = TgtDefMI;
+    unsigned RelBaseReg = RISCV::NoRegister;
+    if (TgtDefMI->getOpcode() == RISCV::ADD) {
+      MBBInstrsToErase.push_back(TgtDefMI);
+      for (unsigned OpIdx : {1, 2}) {
+        MachineInstr *DefMI =
+            getPrecedingDef(*TgtDefMI, TgtDefMI->getOperand(OpIdx).getReg());
+        if (DefMI != nullptr && DefMI->getOpcode() == RISCV::LW) {
+          LoadMI = DefMI;
+          RelBaseReg = TgtDefMI->getOperand(3 - OpIdx).getReg();
+        }
+      }
+    }
+    if (LoadMI->getOpcode() != RISCV::LW)
+      continue;
+    MBBInstrsToErase.push_back(LoadMI);
+
+    // Find the table address plus scaled index computation.
+    MachineInstr *AddrMI =
+        getPrecedingDef(*LoadMI, LoadMI->getOperand(1).getReg());
+    if (AddrMI == nullptr || AddrMI->getOpcode() != RISCV::ADD)
+      continue;
+    MBBInstrsToErase.push_back(AddrMI);
+    MachineInstr *ShiftMI = nullptr;
+    MachineInstr *BaseMI = nullptr;
+    for (unsigned OpIdx : {1, 2}) {
+      MachineInstr *DefMI =
+          getPrecedingDef(*AddrMI, AddrMI->getOperand(OpIdx).getReg());
+      if (DefMI == nullptr)
+        continue;
+      if (DefMI->getOpcode() == RISCV::SLLI &&
+          DefMI->getOperand(2).getImm() == 2)
+        ShiftMI = DefMI;
+      else if (DefMI->getOpcode() == RISCV::ADDI)
+        BaseMI = DefMI;
+    }
+    if (ShiftMI == nullptr || BaseMI == nullptr)
+      continue;
+    unsigned BaseReg = BaseMI->getOperand(0).getReg();
+    if (RelBaseReg != RISCV::NoRegister && RelBaseReg != BaseReg)
+      continue;
+    MachineInstr *HiMI =
+        getPrecedingDef(*BaseMI, BaseMI->getOperand(1).getReg());
+    if (HiMI == nullptr || (HiMI->getOpcode() != RISCV::LUI &&
+                            HiMI->getOpcode() != RISCV::AUIPC))
+      continue;
+    MBBInstrsToErase.push_back(ShiftMI);
+    MBBInstrsToErase.push_back(BaseMI);
+    MBBInstrsToErase.push_back(HiMI);
+
+    // Compute the table address.
+    uint64_t TableAddr =
+        static_cast<uint32_t>((HiMI->getOperand(1).getImm() & 0xFFFFF) << 12);
+    if (HiMI->getOpcode() == RISCV::AUIPC)
+      TableAddr += TextSectionAddress + MCIR->getMCInstIndex(*HiMI);
+    TableAddr +=
+        BaseMI->getOperand(2).getImm() + LoadMI->getOperand(2).getImm();
+    TableAddr = static_cast<uint32_t>(TableAddr);
+
+    // The block is reached from the bounds check of the table index, which
+    // branches to the default block otherwise.
+    if (MBB.pred_size() != 1)
+      continue;
+    MachineBasicBlock *PredMBB = *MBB.pred_begin();
+    if (PredMBB->succ_size() != 2)
+      continue;
+    unsigned IdxReg = ShiftMI->getOperand(1).getReg();
+    uint64_t NumEntries = 0;
+    if (!getJumpTableBound(PredMBB, IdxReg, NumEntries))
+      continue;
+
+    std::vector<MachineBasicBlock *> JmpTgtMBBvec;
+    if (!readJumpTableTargets(TableAddr, NumEntries,
+                              RelBaseReg != RISCV::NoRegister, JmpTgtMBBvec))
+      continue;
+
+    // Erase the table address computation only where its results have no
+    // other uses; the instructions that remain are left for DCE. Uses are
+    // checked before defs, so that the defs a kept instruction reads are
+    // kept as well.
+    SmallPtrSet<MachineInstr *, 8> Erased;
+    Erased.insert(&JmpMI);
+    for (auto MI : MBBInstrsToErase)
+      if (isDeadDef(*MI, JmpTgtMBBvec, Erased))
+        Erased.insert(MI);
+    // The jump table dispatch reads the table index at the end of the block,
+    // so none of the kept instructions may redefine it.
+    bool IsIdxRedefined = false;
+    for (auto I = ShiftMI->getIterator(), E = MBB.end(); I != E; ++I)
+      if (!Erased.count(&*I) && I->definesRegister(IdxReg))
+        IsIdxRedefined = true;
+    if (IsIdxRedefined)
+      continue;
+
+    JumpTableInfo JmpTblInfo;
+    JmpTblInfo.conditionMBB = PredMBB;
+    for (auto Succ : PredMBB->successors())
+      if (Succ != &MBB)
+        JmpTblInfo.df_MBB = Succ;
+    MachineJumpTableInfo *JTI =
+        MF.getOrCreateJumpTableInfo(llvm::MachineJumpTableInfo::EK_Inline);
+    JmpTblInfo.jtIdx = JTI->createJumpTableIndex(JmpTgtMBBvec);
+
+    // The targets of the indirect jump were not known when the CFG was built.
+    for (auto TgtMBB : JmpTgtMBBvec)
+      if (!MBB.isSuccessor(TgtMBB))
+        MBB.addSuccessor(TgtMBB);
+
+    // Keep the metadata of the jump to record its MCInst index.
+    BuildMI(&MBB, DebugLoc(), TII->get(RISCV::PseudoBRIND))
+        .addJumpTableIndex(JmpTblInfo.jtIdx)
+        .addReg(IdxReg)
+        .add(JmpMI.getOperand(JmpMI.getNumExplicitOperands()));
+    JmpMI.eraseFromParent();
+
+    for (auto MI : MBBInstrsToErase)
+      if (Erased.count(MI))
+        MI->eraseFromParent();
+    jtList.push_back(JmpTblInfo);
+  }
   return true;
 }
 
@@ -17,6 +17,7 @@
 #include "RISCV32RaiserBase.h"
 #include "MCInstRaiser.h"
 #include "MachineFunctionRaiser.h"
+#include "llvm/ADT/SmallPtrSet.h"
 
 class RISCV32CreateJumpTable : public RISCV32RaiserBase {
 public:
@@ -36,6 +37,15 @@ private:
   /// Get the MachineBasicBlock to add the jumptable instruction.
   MachineBasicBlock *checkJumptableBB(MachineFunction &MF);
   bool UpdatetheBranchInst(MachineBasicBlock &MBB);
+  MachineInstr *getPrecedingDef(MachineInstr &MI, unsigned Reg);
+  bool isDeadDef(MachineInstr &MI,
+                 const std::vector<MachineBasicBlock *> &Succs,
+                 const SmallPtrSetImpl<MachineInstr *> &Erased);
+  bool getJumpTableBound(MachineBasicBlock *PredMBB, unsigned IdxReg,
+                         uint64_t &NumEntries);
+  bool readJumpTableTargets(uint64_t TableAddr, uint64_t NumEntries,
+                            bool IsRelative,
+                            std::vector<MachineBasicBlock *> &Targets);
 
   std::vector<JumpTableInfo> jtList;
   MCInstRaiser *MCIR;
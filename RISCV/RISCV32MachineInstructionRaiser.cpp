@@ -74,6 +74,7 @@ bool RISCV32MachineInstructionRaiser::raiseMachineFunction() {
   RISCV32SelectionDAGISel sdis(rmr);
   sdis.init(&MF, raisedFunction);
   sdis.setjtList(jtList);
+  sdis.setMCInstRaiser(mcInstRaiser);
   sdis.doSelection();
 
   return true;
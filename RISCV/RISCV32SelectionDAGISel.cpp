@@ -20,7 +20,7 @@ char RISCV32SelectionDAGISel::ID = 0;
 #define DEBUG_TYPE "mctoll"
 
 RISCV32SelectionDAGISel::RISCV32SelectionDAGISel(RISCV32ModuleRaiser &mr)
-    : RISCV32RaiserBase(ID, mr) {}
+    : RISCV32RaiserBase(ID, mr), MCIR(nullptr) {}
 
 RISCV32SelectionDAGISel::~RISCV32SelectionDAGISel() {
   delete SLT;
@@ -86,6 +86,7 @@ void RISCV32SelectionDAGISel::emitDAG() {
   LLVM_DEBUG(dbgs() << "\n--- EmitDAG ----\n");
   RISCVIREmitter imt(BB, DAGInfo, FuncInfo);
   imt.setjtList(jtList);
+  imt.setMCInstRaiser(MCIR);
   SelectionDAG::allnodes_iterator ISelPosition = CurDAG->allnodes_begin();
   while (ISelPosition != CurDAG->allnodes_end()) {
     SDNode *Node = &*ISelPosition++;
@@ -96,17 +97,6 @@ void RISCV32SelectionDAGISel::emitDAG() {
   }
 }
 
-void RISCV32SelectionDAGISel::initEntryBasicBlock() {
-  BasicBlock *bb = &RF->getEntryBlock();
-  for (unsigned i = 0; i < 4; i++) {
-    Align MALG(32);
-    AllocaInst *Alloc = new AllocaInst(Type::getInt1Ty(RF->getContext()), 0,
-                                       nullptr, MALG, "", bb);
-    FuncInfo->AllocaMap[i] = Alloc;
-    new StoreInst(ConstantInt::getFalse(RF->getContext()), Alloc, bb);
-  }
-}
-
 bool RISCV32SelectionDAGISel::doSelection() {
   LLVM_DEBUG(dbgs() << "RISCV32SelectionDAGISel start.\n");
 
@@ -114,7 +104,6 @@ bool RISCV32SelectionDAGISel::doSelection() {
   CurDAG->init(mf, *ORE.get(), this, nullptr, nullptr, nullptr, nullptr);
   FuncInfo->set(*MR, *getCRF(), mf, CurDAG);
 
-  initEntryBasicBlock();
   for (MachineBasicBlock &mbb : mf) {
     MBB = &mbb;
     BB = FuncInfo->getOrCreateBasicBlock(MBB);
@@ -160,6 +149,10 @@ bool RISCV32SelectionDAGISel::setjtList(std::vector<JumpTableInfo> &List) {
   return true;
 }
 
+void RISCV32SelectionDAGISel::setMCInstRaiser(MCInstRaiser *PMCIR) {
+  MCIR = PMCIR;
+}
+
 bool RISCV32SelectionDAGISel::runOnMachineFunction(MachineFunction &mf) {
   bool rtn = false;
   init();
@@ -20,6 +20,7 @@
 #include "RISCVFunctionRaisingInfo.h"
 #include "RISCVIREmitter.h"
 #include "RISCVInstSelector.h"
+#include "MCInstRaiser.h"
 #include "ModuleRaiser.h"
 #include "llvm/Analysis/OptimizationRemarkEmitter.h"
 
@@ -33,10 +34,10 @@ public:
   bool doSelection();
   bool runOnMachineFunction(MachineFunction &mf) override;
   bool setjtList(std::vector<JumpTableInfo> &List);
+  void setMCInstRaiser(MCInstRaiser *PMCIR);
   static char ID;
 
 private:
-  void initEntryBasicBlock();
   void selectBasicBlock();
   void doInstructionSelection();
   void emitDAG();
@@ -52,6 +53,7 @@ private:
   MachineBasicBlock *MBB;
   BasicBlock *BB;
   std::vector<JumpTableInfo> jtList;
+  MCInstRaiser *MCIR;
 };
 
 #endif // LLVM_TOOLS_LLVM_MCTOLL_RISCV32_RISCV32SELECTIONDAGISEL_H
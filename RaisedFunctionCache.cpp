@@ -0,0 +1,203 @@
+//===-- RaisedFunctionCache.cpp ---------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the implementation of the on-disk cache of raised
+// functions specified via the --raised-function-cache option.
+//
+//===----------------------------------------------------------------------===//
+
+#include "RaisedFunctionCache.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/DebugInfo.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
+
+namespace {
+// Collects the global values that a raised function refers to, directly or
+// through constant expressions, metadata and initializers of the global
+// variables it refers to.
+class GlobalRefCollector {
+public:
+  void addValue(const Value *V);
+  void addMetadata(const Metadata *MD);
+
+  SetVector<const GlobalValue *> Refs;
+
+private:
+  SmallPtrSet<const Value *, 32> VisitedValues;
+  SmallPtrSet<const Metadata *, 32> VisitedMD;
+};
+} // end anonymous namespace
+
+void GlobalRefCollector::addValue(const Value *V) {
+  if (!isa<Constant>(V) && !isa<MetadataAsValue>(V))
+    return;
+  if (!VisitedValues.insert(V).second)
+    return;
+
+  if (auto *MAV = dyn_cast<MetadataAsValue>(V)) {
+    addMetadata(MAV->getMetadata());
+    return;
+  }
+  if (auto *GV = dyn_cast<GlobalValue>(V)) {
+    Refs.insert(GV);
+    if (auto *GVar = dyn_cast<GlobalVariable>(GV)) {
+      if (GVar->hasInitializer())
+        addValue(GVar->getInitializer());
+      SmallVector<std::pair<unsigned, MDNode *>, 4> MDs;
+      GVar->getAllMetadata(MDs);
+      for (auto &MD : MDs)
+        addMetadata(MD.second);
+    }
+    return;
+  }
+  for (const Use &Op : cast<Constant>(V)->operands())
+    addValue(Op.get());
+}
+
+void GlobalRefCollector::addMetadata(const Metadata *MD) {
+  if (!VisitedMD.insert(MD).second)
+    return;
+
+  if (auto *VAM = dyn_cast<ValueAsMetadata>(MD)) {
+    addValue(VAM->getValue());
+    return;
+  }
+  if (auto *N = dyn_cast<MDNode>(MD))
+    for (const MDOperand &Op : N->operands())
+      if (Op)
+        addMetadata(Op.get());
+}
+
+std::string RaisedFunctionCache::getEntryPath(StringRef Key) const {
+  SmallString<256> Path(Dir);
+  sys::path::append(Path, Key + ".bc");
+  return std::string(Path.str());
+}
+
+std::unique_ptr<Module> RaisedFunctionCache::load(StringRef Key,
+                                                  LLVMContext &Ctx) const {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> Buf =
+      MemoryBuffer::getFile(getEntryPath(Key));
+  if (!Buf)
+    return nullptr;
+
+  Expected<std::unique_ptr<Module>> CM =
+      parseBitcodeFile((*Buf)->getMemBufferRef(), Ctx);
+  if (!CM) {
+    consumeError(CM.takeError());
+    return nullptr;
+  }
+  // Do not use a damaged entry.
+  if (verifyModule(**CM))
+    return nullptr;
+  return std::move(*CM);
+}
+
+bool RaisedFunctionCache::store(StringRef Key, const Function &F) const {
+  GlobalRefCollector Collector;
+  for (const Instruction &I : instructions(F)) {
+    for (const Use &Op : I.operands())
+      Collector.addValue(Op.get());
+    SmallVector<std::pair<unsigned, MDNode *>, 4> MDs;
+    I.getAllMetadata(MDs);
+    for (auto &MD : MDs)
+      Collector.addMetadata(MD.second);
+  }
+
+  // Build a module with a copy of F, declarations of the functions it refers
+  // to and copies of the global variables it refers to.
+  const Module *M = F.getParent();
+  Module CM(F.getName(), F.getContext());
+  CM.setTargetTriple(M->getTargetTriple());
+  CM.setDataLayout(M->getDataLayout());
+
+  ValueToValueMapTy VMap;
+  Function *NewF = Function::Create(F.getFunctionType(), F.getLinkage(),
+                                    F.getAddressSpace(), F.getName(), &CM);
+  VMap[&F] = NewF;
+  for (const GlobalValue *GV : Collector.Refs) {
+    if (GV == &F)
+      continue;
+    if (auto *RefF = dyn_cast<Function>(GV)) {
+      Function *Decl = Function::Create(
+          RefF->getFunctionType(), GlobalValue::ExternalLinkage,
+          RefF->getAddressSpace(), RefF->getName(), &CM);
+      Decl->copyAttributesFrom(RefF);
+      VMap[RefF] = Decl;
+      continue;
+    }
+    // Raised functions do not refer to aliases.
+    auto *GVar = dyn_cast<GlobalVariable>(GV);
+    if (GVar == nullptr)
+      return false;
+    auto *NewGVar = new GlobalVariable(
+        CM, GVar->getValueType(), GVar->isConstant(), GVar->getLinkage(),
+        nullptr, GVar->getName(), nullptr, GVar->getThreadLocalMode(),
+        GVar->getType()->getAddressSpace());
+    NewGVar->copyAttributesFrom(GVar);
+    VMap[GVar] = NewGVar;
+  }
+  for (const GlobalValue *GV : Collector.Refs) {
+    auto *GVar = dyn_cast<GlobalVariable>(GV);
+    if (GVar == nullptr)
+      continue;
+    auto *NewGVar = cast<GlobalVariable>(VMap[GVar]);
+    if (GVar->hasInitializer())
+      NewGVar->setInitializer(MapValue(GVar->getInitializer(), VMap));
+    SmallVector<std::pair<unsigned, MDNode *>, 4> MDs;
+    GVar->getAllMetadata(MDs);
+    for (auto &MD : MDs)
+      NewGVar->addMetadata(MD.first, *MapMetadata(MD.second, VMap));
+  }
+
+  Function::arg_iterator NewArg = NewF->arg_begin();
+  for (const Argument &Arg : F.args()) {
+    NewArg->setName(Arg.getName());
+    VMap[&Arg] = &*NewArg++;
+  }
+  SmallVector<ReturnInst *, 8> Returns;
+  CloneFunctionInto(NewF, &F, VMap, /*ModuleLevelChanges=*/true, Returns);
+  // Address debug information is not cached.
+  StripDebugInfo(CM);
+
+  if (sys::fs::create_directories(Dir))
+    return false;
+  std::string EntryPath = getEntryPath(Key);
+  SmallString<256> TempFile;
+  int FD;
+  if (sys::fs::createUniqueFile(EntryPath + ".tmp-%%%%%%", FD, TempFile))
+    return false;
+  {
+    raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    WriteBitcodeToFile(CM, OS);
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      sys::fs::remove(TempFile);
+      return false;
+    }
+  }
+  // Replace the entry atomically, so that concurrent raisers sharing the
+  // cache read either the old or the new entry.
+  if (sys::fs::rename(TempFile, EntryPath)) {
+    sys::fs::remove(TempFile);
+    return false;
+  }
+  return true;
+}
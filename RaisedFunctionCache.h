@@ -0,0 +1,50 @@
+//===-- RaisedFunctionCache.h -----------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the declaration of the on-disk cache of raised functions
+// specified via the --raised-function-cache option. Each entry is a bitcode
+// module holding one raised function, and is stored under a key that the
+// module raiser computes from the function's instructions and context.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TOOLS_LLVM_MCTOLL_RAISEDFUNCTIONCACHE_H
+#define LLVM_TOOLS_LLVM_MCTOLL_RAISEDFUNCTIONCACHE_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include <memory>
+#include <string>
+
+using namespace llvm;
+
+class RaisedFunctionCache {
+public:
+  RaisedFunctionCache(StringRef Dir) : Dir(Dir.str()) {}
+
+  // Return the module cached under Key, read into context Ctx. The module
+  // defines the cached raised function and declares or defines the functions
+  // and global variables it refers to. Return nullptr if there is no valid
+  // entry for Key.
+  std::unique_ptr<Module> load(StringRef Key, LLVMContext &Ctx) const;
+
+  // Cache raised function F under Key, together with copies of the global
+  // variables it refers to and declarations of the functions it refers to.
+  // Return false if the entry can not be written.
+  bool store(StringRef Key, const Function &F) const;
+
+private:
+  std::string getEntryPath(StringRef Key) const;
+
+  // Directory holding one bitcode file per entry
+  std::string Dir;
+};
+
+#endif // LLVM_TOOLS_LLVM_MCTOLL_RAISEDFUNCTIONCACHE_H
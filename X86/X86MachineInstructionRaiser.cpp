@@ -12,6 +12,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "X86MachineInstructionRaiser.h"
+#include "BranchProfile.h"
 #include "ExternalFunctions.h"
 #include "MachineFunctionRaiser.h"
 #include "X86InstrBuilder.h"
@@ -63,6 +64,10 @@ X86MachineInstructionRaiser::X86MachineInstructionRaiser(MachineFunction &MF,
   raisedValues = nullptr;
 }
 
+X86MachineInstructionRaiser::~X86MachineInstructionRaiser() {
+  delete raisedValues;
+}
+
 bool X86MachineInstructionRaiser::raisePushInstruction(const MachineInstr &MI) {
   const MCInstrDesc &MCIDesc = MI.getDesc();
   uint64_t MCIDTSFlags = MCIDesc.TSFlags;
@@ -3355,12 +3360,29 @@ bool X86MachineInstructionRaiser::raiseIndirectBranchMachineInstr(
     BasicBlock *df_bb = intr_df->second;
     SwitchInst *Inst = SwitchInst::Create(cdi, df_bb, numCases);
 
+    // Addresses of the default and case destinations, in the order of
+    // successors of the switch instruction.
+    MCInstRaiser *MCIR = getMCInstRaiser();
+    int64_t TextSectionAddress = MR->getTextSectionAddress();
+    std::vector<uint64_t> TargetAddrs;
+    TargetAddrs.push_back(TextSectionAddress +
+                          MCIR->getMCInstOffsetOfMBBNumber(
+                              jtList[jtIndex].df_MBB->getNumber()));
     for (unsigned i = 0, e = numCases; i != e; ++i) {
       MachineBasicBlock *Mbb = JTCases[i].second;
       auto intr = mbbToBBMap.find(Mbb->getNumber());
       BasicBlock *bb = intr->second;
       Inst->addCase(JTCases[i].first, bb);
+      TargetAddrs.push_back(TextSectionAddress +
+                            MCIR->getMCInstOffsetOfMBBNumber(Mbb->getNumber()));
     }
+    // The jump table branch is rebuilt during jump table discovery and no
+    // longer records its address. Weigh the destinations by the number of
+    // transfers to each of them instead.
+    if (MDNode *Weights =
+            BranchProfile::getIndirectBranchWeights(CandBB->getContext(),
+                                                    TargetAddrs))
+      Inst->setMetadata(LLVMContext::MD_prof, Weights);
 
     CandBB->getInstList().push_back(Inst);
     CTRec->Raised = true;
@@ -3664,6 +3686,15 @@ bool X86MachineInstructionRaiser::raiseDirectBranchMachineInstr(
 
     // Create branch instruction
     BranchInst *CondBr = BranchInst::Create(TgtBB, FTBB, BranchCond);
+    // Weigh the taken and fall-through edges with their profiled counts. The
+    // fall-through edge is recorded to the instruction following the branch.
+    int64_t TextSectionAddress = MR->getTextSectionAddress();
+    uint64_t BranchAddr = TextSectionAddress + MCInstOffset;
+    if (MDNode *Weights = BranchProfile::getBranchWeights(
+            Ctx, BranchAddr,
+            {TextSectionAddress + BranchTargetOffset,
+             BranchAddr + MCIR->getMCInstSize(MCInstOffset)}))
+      CondBr->setMetadata(LLVMContext::MD_prof, Weights);
     CandBB->getInstList().push_back(CondBr);
     CTRec->Raised = true;
   } else {
@@ -3740,7 +3771,7 @@ bool X86MachineInstructionRaiser::raiseGenericMachineInstr(
 // Raise a return instruction.
 bool X86MachineInstructionRaiser::raiseReturnMachineInstr(
     const MachineInstr &MI) {
-  Type *RetType = raisedFunction->getReturnType();
+  Type *RetType = MR->getRaisedFunctionReturnType(raisedFunction);
   Value *RetValue = nullptr;
 
   // Get the BasicBlock corresponding to MachineBasicBlock of MI.
@@ -3790,7 +3821,7 @@ bool X86MachineInstructionRaiser::raiseReturnMachineInstr(
   // Make sure that the return type of raisedFunction is void. Else change it to
   // void type as reaching definition computation is more accurate than that
   // deduced earlier just looking at the per-basic block definitions.
-  Type *RaisedFuncReturnTy = raisedFunction->getReturnType();
+  Type *RaisedFuncReturnTy = MR->getRaisedFunctionReturnType(raisedFunction);
   if (RetValue == nullptr) {
     if (!RaisedFuncReturnTy->isVoidTy()) {
       ModuleRaiser *NonConstMR = const_cast<ModuleRaiser *>(MR);
@@ -3822,6 +3853,7 @@ bool X86MachineInstructionRaiser::raiseBranchMachineInstrs() {
         success &= raiseIndirectBranchMachineInstr(CTRec);
         assert(success && "Failed to raise indirect branch instruction");
       }
+      setRaisedInstrsDebugLoc(*MI, CTRec->CandidateBlock);
     }
   }
 
@@ -4097,19 +4129,24 @@ bool X86MachineInstructionRaiser::raiseCallMachineInstr(
       CallInstFuncArgs.push_back(ArgVal);
     }
 
-    // Construct call inst.
+    // Construct call inst. The return type of the callee may have been
+    // changed while raising it. The change is applied to the callee once all
+    // functions are raised, so call a cast of the callee with the changed
+    // return type until then.
+    Type *RetType = MR->getRaisedFunctionReturnType(CalledFunc);
+    FunctionType *CallFT = CalledFunc->getFunctionType();
+    Value *Callee = CalledFunc;
+    if (RetType != CallFT->getReturnType()) {
+      CallFT =
+          FunctionType::get(RetType, CallFT->params(), CallFT->isVarArg());
+      Callee = ConstantExpr::getBitCast(CalledFunc, CallFT->getPointerTo());
+    }
     Instruction *callInst =
-        CallInst::Create(CalledFunc, ArrayRef<Value *>(CallInstFuncArgs));
-
-    // If this is a branch being turned to a tail call set the flag
-    // accordingly.
-    if (MI.isBranch())
-      dyn_cast<CallInst>(callInst)->setTailCall(true);
+        CallInst::Create(CallFT, Callee, ArrayRef<Value *>(CallInstFuncArgs));
 
     RaisedBB->getInstList().push_back(callInst);
     // A function call with a non-void return will modify
     // RAX (or its sub-register).
-    Type *RetType = CalledFunc->getReturnType();
     if (!RetType->isVoidTy()) {
       unsigned int RetReg = X86::NoRegister;
       if (RetType->isPointerTy()) {
@@ -4143,13 +4180,15 @@ bool X86MachineInstructionRaiser::raiseCallMachineInstr(
     }
     if (MI.isBranch()) {
       // Emit appropriate ret instruction. There will be no ret instruction
-      // in the binary since this is a tail call.
+      // in the binary since this is a tail call. The function returns what
+      // its callee returns.
       ReturnInst *RetInstr;
-      if (RetType->isVoidTy())
+      ModuleRaiser *NonConstMR = const_cast<ModuleRaiser *>(MR);
+      if (RetType->isVoidTy()) {
         RetInstr = ReturnInst::Create(Ctx);
-      else {
+        NonConstMR->changeRaisedFunctionReturnType(raisedFunction, RetType);
+      } else {
         RetInstr = ReturnInst::Create(Ctx, callInst);
-        ModuleRaiser *NonConstMR = const_cast<ModuleRaiser *>(MR);
         NonConstMR->changeRaisedFunctionReturnType(raisedFunction,
                                                    callInst->getType());
       }
@@ -4325,12 +4364,41 @@ bool X86MachineInstructionRaiser::raiseMachineFunction() {
       } else if (!raiseMachineInstr(MI)) {
         return false;
       }
+      setRaisedInstrsDebugLoc(MI, CurIBB);
     }
   }
   return createFunctionStackFrame() && raiseBranchMachineInstrs() &&
          handleUnpromotedReachingDefs();
 }
 
+void X86MachineInstructionRaiser::setRaisedInstrsDebugLoc(
+    const MachineInstr &MI, BasicBlock *BB) {
+  // Instructions built after discovery of the input binary, such as jump
+  // table branches, do not record the offset of an MCInst.
+  unsigned NumExpOps = MI.getNumExplicitOperands();
+  if (MI.getNumOperands() <= NumExpOps ||
+      !MI.getOperand(NumExpOps).isMetadata())
+    return;
+
+  MCInstRaiser *MCIR = getMCInstRaiser();
+  int64_t TextSectionAddress = MR->getTextSectionAddress();
+  DISubprogram *SP = MR->getOrCreateAddressSubprogram(
+      raisedFunction, TextSectionAddress + MCIR->getFuncStart());
+  if (SP == nullptr)
+    return;
+
+  uint64_t Addr = TextSectionAddress + MCIR->getMCInstIndex(MI);
+  DebugLoc Loc = DILocation::get(BB->getContext(),
+                                 static_cast<unsigned>(Addr), 0, SP);
+  // Instructions raised from MI are appended to BB after those of earlier
+  // MachineInstrs, all of which already have a location.
+  for (Instruction &I : reverse(*BB)) {
+    if (I.getDebugLoc())
+      break;
+    I.setDebugLoc(Loc);
+  }
+}
+
 bool X86MachineInstructionRaiser::raise() {
   bool Success = raiseMachineFunction();
   if (Success) {
@@ -4343,10 +4411,16 @@ bool X86MachineInstructionRaiser::raise() {
 
     DeleteDeadBlocks(ArrayRef<BasicBlock *>(UnConnectedBEmptyBs));
 
-    // Unify all exit nodes of the raised function
-    legacy::PassManager PM;
-    PM.add(createUnifyFunctionExitNodesPass());
-    PM.run(*(raisedFunction->getParent()));
+    // Unify all exit nodes of the raised function. The returns of a function
+    // whose return type changed are unified once the change is applied.
+    if (MR->getRaisedFunctionReturnType(raisedFunction) ==
+        raisedFunction->getReturnType()) {
+      legacy::FunctionPassManager FPM(raisedFunction->getParent());
+      FPM.add(createUnifyFunctionExitNodesPass());
+      FPM.doInitialization();
+      FPM.run(*raisedFunction);
+      FPM.doFinalization();
+    }
   }
   return Success;
 }
@@ -51,6 +51,7 @@ public:
   X86MachineInstructionRaiser() = delete;
   X86MachineInstructionRaiser(MachineFunction &MF, const ModuleRaiser *MR,
                               MCInstRaiser *MIR);
+  ~X86MachineInstructionRaiser() override;
   bool raise() override;
 
   // Return the 64-bit super-register of PhysReg.
@@ -105,6 +106,9 @@ private:
   Value *getRegOrArgValue(unsigned PReg, int MBBNo) override;
 
   bool raiseMachineFunction();
+  // Attach the address of MI to the instructions at the end of BB raised from
+  // it, if address debug information is enabled.
+  void setRaisedInstrsDebugLoc(const MachineInstr &MI, BasicBlock *BB);
   FunctionType *getRaisedFunctionPrototype() override;
   // This raises MachineInstr to MachineInstruction
   bool raiseMachineInstr(MachineInstr &);
@@ -152,6 +156,7 @@ private:
   bool unlinkEmptyMBBs();
   // Adjust sizes of stack allocated objects
   bool createFunctionStackFrame();
+  bool isStackFrameLayoutRequired();
 
   // Method to record information that is used in a second pass
   // to raise control transfer instructions in a second pass.
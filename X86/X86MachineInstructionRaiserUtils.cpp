@@ -17,6 +17,7 @@
 #include "X86RaisedValueTracker.h"
 #include "X86RegisterUtils.h"
 #include "llvm-mctoll.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Object/ELF.h"
 #include "llvm/Object/ELFObjectFile.h"
 #include "llvm/Transforms/Utils/BasicBlockUtils.h"
@@ -781,6 +782,68 @@ bool X86MachineInstructionRaiser::handleUnpromotedReachingDefs() {
   return true;
 }
 
+// Return true if every use of StackObj is a load from or a store to it -
+// either directly or through pointer casts - that accesses no more than the
+// size of StackObj. Any other use (address computation, pointer escape to a
+// call or memory etc.) may depend on the layout of neighbouring stack objects.
+static bool hasOnlyInBoundsAccesses(const AllocaInst *StackObj,
+                                    const DataLayout &DL) {
+  uint64_t ObjSzInBytes = StackObj->getAllocationSizeInBits(DL).getValue() / 8;
+  SmallVector<const Value *, 8> WorkList;
+  SmallPtrSet<const Value *, 8> Visited;
+  WorkList.push_back(StackObj);
+  while (!WorkList.empty()) {
+    const Value *Ptr = WorkList.pop_back_val();
+    if (!Visited.insert(Ptr).second)
+      continue;
+    for (const User *U : Ptr->users()) {
+      if (auto *LdInst = dyn_cast<LoadInst>(U)) {
+        if (DL.getTypeStoreSize(LdInst->getType()) > ObjSzInBytes)
+          return false;
+      } else if (auto *StInst = dyn_cast<StoreInst>(U)) {
+        // Storing the address of the stack object makes it escape.
+        if (StInst->getValueOperand() == Ptr)
+          return false;
+        if (DL.getTypeStoreSize(StInst->getValueOperand()->getType()) >
+            ObjSzInBytes)
+          return false;
+      } else if (auto *BCInst = dyn_cast<BitCastInst>(U)) {
+        WorkList.push_back(BCInst);
+      } else
+        return false;
+    }
+  }
+  return true;
+}
+
+// Return true if the raised code depends on the relative placement of the
+// non-spill stack objects of the function i.e., if any of the stack objects
+// overlaps the next one, has its address taken or is accessed beyond its
+// bounds.
+bool X86MachineInstructionRaiser::isStackFrameLayoutRequired() {
+  MachineFrameInfo &MFrameInfo = MF.getFrameInfo();
+  const DataLayout &DL = MR->getModule()->getDataLayout();
+  // Stack objects that share bytes can not be allocated separately.
+  for (auto StackSlot = ShadowStackIndexedByOffset.begin(),
+            NextStackSlot = std::next(StackSlot);
+       NextStackSlot != ShadowStackIndexedByOffset.end();
+       StackSlot = NextStackSlot++) {
+    int64_t ObjEnd =
+        StackSlot->first + MFrameInfo.getObjectSize(StackSlot->second);
+    if (ObjEnd > NextStackSlot->first)
+      return true;
+  }
+  for (auto StackSlot : ShadowStackIndexedByOffset) {
+    int StackIndex = StackSlot.second;
+    if (MFrameInfo.isSpillSlotObjectIndex(StackIndex))
+      continue;
+    const AllocaInst *StackObj = MFrameInfo.getObjectAllocation(StackIndex);
+    if (!hasOnlyInBoundsAccesses(StackObj, DL))
+      return true;
+  }
+  return false;
+}
+
 // Create a single stack frame based on stack allocations of the Function.
 // The single stack frame thus created is expected to preserve the frame layout
 // of the source binary - as represented by the various stack allocations. This
@@ -791,9 +854,13 @@ bool X86MachineInstructionRaiser::handleUnpromotedReachingDefs() {
 // fracturing aggregate data. This function abstracts all stack objects into
 // a single frame to ensures the stack layout in source binary is preserved and
 // prevent aggregate data fractures on the stack.
+// If none of the accesses to stack objects depend on the frame layout, each
+// stack object is left as a separate typed alloca. This allows SROA and
+// mem2reg to promote them independently when the raised code is optimized.
 bool X86MachineInstructionRaiser::createFunctionStackFrame() {
-  // If there are stack objects allocated
-  if (ShadowStackIndexedByOffset.size() > 1) {
+  // If there are stack objects allocated and their layout needs to be
+  // preserved
+  if ((ShadowStackIndexedByOffset.size() > 1) && isStackFrameLayoutRequired()) {
     MachineFrameInfo &MFrameInfo = MF.getFrameInfo();
     const DataLayout &dataLayout = MR->getModule()->getDataLayout();
     unsigned allocaAddrSpace = dataLayout.getAllocaAddrSpace();
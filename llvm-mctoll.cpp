@@ -11,6 +11,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm-mctoll.h"
+#include "BranchProfile.h"
 #include "EmitRaisedOutputPass.h"
 #include "ExternalFunctions.h"
 #include "MCInstOrData.h"
@@ -18,8 +19,12 @@
 #include "ModuleRaiser.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/ScopeExit.h"
 #include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/Triple.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/Bitcode/BitcodeWriterPass.h"
 #include "llvm/CodeGen/FaultMaps.h"
@@ -28,6 +33,7 @@
 #include "llvm/CodeGen/MachineModuleInfo.h"
 #include "llvm/CodeGen/Passes.h"
 #include "llvm/CodeGen/TargetPassConfig.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/DebugInfo/DWARF/DWARFContext.h"
 #include "llvm/DebugInfo/Symbolize/Symbolize.h"
 #include "llvm/IR/Function.h"
@@ -36,6 +42,8 @@
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Type.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/Linker/Linker.h"
 #include "llvm/MC/MCAsmInfo.h"
 #include "llvm/MC/MCContext.h"
 #include "llvm/MC/MCDisassembler/MCDisassembler.h"
@@ -54,6 +62,7 @@
 #include "llvm/Object/MachO.h"
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Object/Wasm.h"
+#include "llvm/Passes/PassBuilder.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
@@ -64,6 +73,7 @@
 #include "llvm/Support/Host.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/SourceMgr.h"
@@ -108,18 +118,44 @@ cl::list<std::string>
            cl::desc("Target specific attributes (-mattr=help for details)"),
            cl::value_desc("a1,+a2,-a3,..."));
 
+// Output file type.
+enum RaisedOutputFormat {
+  ROF_LL,  // LLVM text IR
+  ROF_BC,  // LLVM bitcode
+  ROF_Asm, // Native assembly, compiled in-process
+  ROF_Obj, // Native relocatable object, compiled in-process
+  ROF_Null
+};
+
 // Output file type. Default is binary bitcode.
-cl::opt<CodeGenFileType> OutputFormat(
-    "output-format", cl::init(CGFT_AssemblyFile),
+cl::opt<RaisedOutputFormat> OutputFormat(
+    "output-format", cl::init(ROF_LL),
     cl::desc("Output format (default: binary bitcode):"),
-    cl::values(clEnumValN(CGFT_AssemblyFile, "ll",
-                          "Emit llvm text bitcode ('.ll') file"),
-               clEnumValN(CGFT_ObjectFile, "bc",
+    cl::values(clEnumValN(ROF_LL, "ll", "Emit llvm text bitcode ('.ll') file"),
+               clEnumValN(ROF_BC, "bc",
                           "Emit llvm binary bitcode ('.bc') file"),
-               clEnumValN(CGFT_Null, "null",
+               clEnumValN(ROF_Asm, "asm",
+                          "Emit native assembly ('.s') file for the host"),
+               clEnumValN(ROF_Obj, "obj",
+                          "Emit native object ('.o') file for the host"),
+               clEnumValN(ROF_Null, "null",
                           "Emit nothing, for performance testing")),
     cl::cat(LLVMMCToLLCategory), cl::NotHidden);
 
+static cl::opt<char> OptLevel(
+    "O",
+    cl::desc("Optimize the raised functions before writing them. "
+             "[-O0, -O1, -O2, or -O3] (default = '-O0')"),
+    cl::Prefix, cl::ZeroOrMore, cl::init('0'), cl::cat(LLVMMCToLLCategory),
+    cl::NotHidden);
+
+static cl::opt<std::string> PassPipeline(
+    "passes",
+    cl::desc("Optimization pipeline, in the textual syntax of the new pass "
+             "manager, to run on the raised module before compiling it for "
+             "--output-format=asm or obj."),
+    cl::init("default<O2>"), cl::cat(LLVMMCToLLCategory), cl::NotHidden);
+
 cl::opt<bool> llvm::Disassemble("raise", cl::desc("Raise machine instruction"),
                                 cl::cat(LLVMMCToLLCategory), cl::NotHidden);
 
@@ -186,6 +222,74 @@ cl::alias static IncludeFileNamesShort(
     cl::aliasopt(llvm::IncludeFileNames), cl::cat(LLVMMCToLLCategory),
     cl::NotHidden);
 
+static cl::opt<std::string> PrototypeDB(
+    "prototype-db",
+    cl::desc("Read the function prototypes of include files that did not "
+             "change from the specified prototype database instead of "
+             "parsing them, and record those of parsed include files in it."),
+    cl::value_desc("filename"), cl::cat(LLVMMCToLLCategory), cl::NotHidden);
+
+static cl::opt<std::string> ProfileFile(
+    "profile",
+    cl::desc("Annotate raised branches and functions with the control "
+             "transfer counts of the input binary recorded in the file, one "
+             "'<from-address> <to-address> <count>' entry per line."),
+    cl::value_desc("filename"), cl::cat(LLVMMCToLLCategory), cl::NotHidden);
+
+static cl::opt<bool> AddressDebugInfo(
+    "address-debug-info",
+    cl::desc("Emit line table debug information with the address of the "
+             "input binary instruction each raised instruction originates "
+             "from as its line number."),
+    cl::cat(LLVMMCToLLCategory), cl::NotHidden);
+
+static cl::opt<bool> ReleaseMachineFunctions(
+    "release-machine-functions",
+    cl::desc("Free the MachineFunction, decoded instructions and raiser "
+             "state of each function as soon as it is raised, to bound peak "
+             "memory use on large binaries."),
+    cl::cat(LLVMMCToLLCategory), cl::NotHidden);
+
+static cl::opt<std::string> RaisedFunctionCacheDir(
+    "raised-function-cache",
+    cl::desc("Reuse the raised functions recorded in the directory for "
+             "functions whose instructions, relocations and referenced "
+             "symbols and data did not change, and record the other raised "
+             "functions in it. Not used with --address-debug-info."),
+    cl::value_desc("directory"), cl::cat(LLVMMCToLLCategory), cl::NotHidden);
+
+static cl::opt<bool> WholeProgram(
+    "whole-program",
+    cl::desc("Raise the input executable together with the shared libraries "
+             "it needs (DT_NEEDED) that are found in the library search "
+             "paths, into a single module with calls through the PLT bound "
+             "to the raised library functions."),
+    cl::cat(LLVMMCToLLCategory), cl::NotHidden);
+
+static cl::list<std::string> LibrarySearchPaths(
+    "library-path",
+    cl::desc("Search the directory for shared libraries needed in "
+             "--whole-program mode. The directory of the executable is "
+             "searched last."),
+    cl::value_desc("directory"), cl::ZeroOrMore, cl::cat(LLVMMCToLLCategory),
+    cl::NotHidden);
+
+cl::alias static LibrarySearchPathsShort(
+    "L", cl::desc("Alias for --library-path"),
+    cl::aliasopt(LibrarySearchPaths), cl::cat(LLVMMCToLLCategory),
+    cl::NotHidden);
+
+static cl::list<std::string> Roots(
+    "roots", cl::CommaSeparated,
+    cl::desc("Raise only the functions reachable from the specified "
+             "functions through direct calls, jumps and references to "
+             "function addresses."),
+    cl::value_desc("symbol,..."), cl::cat(LLVMMCToLLCategory), cl::NotHidden);
+
+// Bitcode of the modules raised in --whole-program mode, the executable's
+// last. They are linked into a single module once all are raised.
+static std::vector<std::string> WholeProgramBitcode;
+
 namespace {
 static ManagedStatic<std::vector<std::string>> RunPassNames;
 
@@ -351,6 +455,81 @@ LLVM_ATTRIBUTE_NORETURN void llvm::report_error(Error E, StringRef ArchiveName,
     report_error(std::move(E), ArchiveName, NameOrErr.get(), ArchitectureName);
 }
 
+// Return the name of the LLVM target, as listed in llvm/Config/Targets.def and
+// Raisers.def, that handles architecture Arch, or an empty string if it is not
+// known.
+static StringRef getTargetBackendName(Triple::ArchType Arch) {
+  switch (Arch) {
+  case Triple::x86:
+  case Triple::x86_64:
+    return "X86";
+  case Triple::arm:
+  case Triple::armeb:
+  case Triple::thumb:
+  case Triple::thumbeb:
+    return "ARM";
+  case Triple::aarch64:
+  case Triple::aarch64_be:
+  case Triple::aarch64_32:
+    return "AArch64";
+  case Triple::riscv32:
+  case Triple::riscv64:
+    return "RISCV";
+  case Triple::ppc:
+  case Triple::ppcle:
+  case Triple::ppc64:
+  case Triple::ppc64le:
+    return "PowerPC";
+  case Triple::mips:
+  case Triple::mipsel:
+  case Triple::mips64:
+  case Triple::mips64el:
+    return "Mips";
+  case Triple::systemz:
+    return "SystemZ";
+  default:
+    return "";
+  }
+}
+
+// Initialize the LLVM target that handles architecture Arch, with its MC
+// layer, disassembler and assembly printer, once per process. All targets are
+// initialized if the target of Arch is not known.
+void llvm::initializeTarget(Triple::ArchType Arch) {
+  static StringSet<> InitializedTargets;
+  StringRef Name = getTargetBackendName(Arch);
+  if (Name.empty()) {
+    static bool AllInitialized = false;
+    if (AllInitialized)
+      return;
+    AllInitialized = true;
+    llvm::InitializeAllTargetInfos();
+    llvm::InitializeAllTargets();
+    llvm::InitializeAllTargetMCs();
+    llvm::InitializeAllDisassemblers();
+    llvm::InitializeAllAsmPrinters();
+    return;
+  }
+  if (!InitializedTargets.insert(Name).second)
+    return;
+
+#define LLVM_TARGET(TargetName)                                                \
+  if (Name == #TargetName) {                                                   \
+    LLVMInitialize##TargetName##TargetInfo();                                  \
+    LLVMInitialize##TargetName##Target();                                      \
+    LLVMInitialize##TargetName##TargetMC();                                    \
+  }
+#include "llvm/Config/Targets.def"
+#define LLVM_DISASSEMBLER(TargetName)                                          \
+  if (Name == #TargetName)                                                     \
+    LLVMInitialize##TargetName##Disassembler();
+#include "llvm/Config/Disassemblers.def"
+#define LLVM_ASM_PRINTER(TargetName)                                           \
+  if (Name == #TargetName)                                                     \
+    LLVMInitialize##TargetName##AsmPrinter();
+#include "llvm/Config/AsmPrinters.def"
+}
+
 static const Target *getTarget(const ObjectFile *Obj = nullptr) {
   // Figure out the target triple.
   llvm::Triple TheTriple("unknown-unknown-unknown");
@@ -395,6 +574,9 @@ static const Target *getTarget(const ObjectFile *Obj = nullptr) {
   // Get the target specific parser.
   // LLVM_DEBUG(dbgs() << "::" << TheTriple.getTriple() << "\n");
   LLVM_DEBUG(dbgs() << "::" << TheTriple.getTriple() << "\n");
+  // A target named via --arch-name may be any one.
+  initializeTarget(ArchName.empty() ? TheTriple.getArch()
+                                    : Triple::UnknownArch);
   std::string Error;
   const Target *TheTarget =
       TargetRegistry::lookupTarget(ArchName, TheTriple, Error);
@@ -435,15 +617,19 @@ static std::unique_ptr<ToolOutputFile> GetOutputStream(const char *TargetName,
       OutputFilename = std::string(IFN);
 
     switch (OutputFormat) {
-    case CGFT_AssemblyFile:
+    case ROF_LL:
       OutputFilename += "-dis.ll";
       break;
-    // Just uses enum CGFT_ObjectFile represent llvm bitcode file type
-    // provisionally.
-    case CGFT_ObjectFile:
+    case ROF_BC:
       OutputFilename += "-dis.bc";
       break;
-    case CGFT_Null:
+    case ROF_Asm:
+      OutputFilename += "-dis.s";
+      break;
+    case ROF_Obj:
+      OutputFilename += "-dis.o";
+      break;
+    case ROF_Null:
       OutputFilename += ".null";
       break;
     }
@@ -452,10 +638,12 @@ static std::unique_ptr<ToolOutputFile> GetOutputStream(const char *TargetName,
   // Decide if we need "binary" output.
   bool Binary = false;
   switch (OutputFormat) {
-  case CGFT_AssemblyFile:
+  case ROF_LL:
+  case ROF_Asm:
     break;
-  case CGFT_ObjectFile:
-  case CGFT_Null:
+  case ROF_BC:
+  case ROF_Obj:
+  case ROF_Null:
     Binary = true;
     break;
   }
@@ -474,6 +662,68 @@ static std::unique_ptr<ToolOutputFile> GetOutputStream(const char *TargetName,
   return FDOut;
 }
 
+// Return the file type EmitRaisedOutputPass uses to write the raised module
+// in the LLVM IR output format.
+static CodeGenFileType getIRFileType() {
+  switch (OutputFormat) {
+  case ROF_LL:
+    return CGFT_AssemblyFile;
+  // Just uses enum CGFT_ObjectFile represent llvm bitcode file type
+  // provisionally.
+  case ROF_BC:
+    return CGFT_ObjectFile;
+  default:
+    return CGFT_Null;
+  }
+}
+
+/// @brief Optimize raised module \a M with PassPipeline and compile it for
+/// the host to \a OS, in memory without writing the IR.
+static void compileRaisedModule(Module &M, raw_pwrite_stream &OS) {
+  std::string HostTriple = sys::getDefaultTargetTriple();
+  initializeTarget(Triple(HostTriple).getArch());
+  std::string Error;
+  const Target *HostTarget = TargetRegistry::lookupTarget(HostTriple, Error);
+  if (!HostTarget)
+    report_error(M.getModuleIdentifier(), Error);
+  std::unique_ptr<TargetMachine> HostTM(HostTarget->createTargetMachine(
+      HostTriple, "generic", "", TargetOptions(), Reloc::PIC_));
+  assert(HostTM && "Could not allocate host target machine!");
+
+  // The raised module is target-neutral but for its data layout, which is
+  // that of the input binary.
+  M.setTargetTriple(HostTriple);
+  M.setDataLayout(HostTM->createDataLayout());
+
+  LoopAnalysisManager LAM;
+  FunctionAnalysisManager FAM;
+  CGSCCAnalysisManager CGAM;
+  ModuleAnalysisManager MAM;
+  PassBuilder PB(/* DebugLogging */ false, HostTM.get());
+  PB.registerModuleAnalyses(MAM);
+  PB.registerCGSCCAnalyses(CGAM);
+  PB.registerFunctionAnalyses(FAM);
+  PB.registerLoopAnalyses(LAM);
+  PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+  ModulePassManager MPM;
+  if (auto Err = PB.parsePassPipeline(MPM, PassPipeline))
+    report_error(std::move(Err), "--passes");
+  if (!NoVerify)
+    MPM.addPass(VerifierPass());
+  MPM.run(M, MAM);
+
+  legacy::PassManager CodeGenPM;
+  CodeGenPM.add(
+      createTargetTransformInfoWrapperPass(HostTM->getTargetIRAnalysis()));
+  CodeGenFileType FileType =
+      (OutputFormat == ROF_Asm) ? CGFT_AssemblyFile : CGFT_ObjectFile;
+  if (HostTM->addPassesToEmitFile(CodeGenPM, OS, nullptr, FileType, NoVerify))
+    report_error(HostTriple, "Target does not support emitting the raised "
+                             "module as native code");
+  CodeGenPM.run(M);
+}
+
 static bool addPass(PassManagerBase &PM, StringRef toolname, StringRef PassName,
                     TargetPassConfig &TPC) {
   if (PassName == "none")
@@ -801,6 +1051,179 @@ static bool isAFunctionSymbol(const ObjectFile *Obj, SymbolInfoTy &Symbol) {
   return false;
 }
 
+// Return the identification of this build of the tool and of the options
+// that affect the raising of functions, to be hashed into the keys of the
+// raised function cache.
+static std::string getRaisedFunctionCacheToolContext() {
+  std::string Context;
+  raw_string_ostream OS(Context);
+  OS << LLVM_VERSION_STRING << '\0';
+  std::string Exe = sys::fs::getMainExecutable(
+      ToolName.data(), (void *)&getRaisedFunctionCacheToolContext);
+  sys::fs::file_status Status;
+  if (!sys::fs::status(Exe, Status))
+    OS << Status.getSize() << '\0'
+       << Status.getLastModificationTime().time_since_epoch().count() << '\0';
+  if (!ProfileFile.empty()) {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> Profile =
+        MemoryBuffer::getFile(ProfileFile);
+    if (Profile)
+      OS << (*Profile)->getBuffer();
+  }
+  return OS.str();
+}
+
+// Text section index and offset of a function.
+using FunctionLocation = std::pair<uint64_t, uint64_t>;
+
+// Return the locations of the functions of the text sections of Obj reachable
+// from the --roots functions. The instructions of reachable functions are
+// decoded as they are discovered to find targets of direct calls and jumps
+// and, in relocatable objects, of call relocations, as well as function start
+// addresses referenced by immediates or memory operands. Targets may be in a
+// text section other than that of the referencing function. Targets of
+// indirect calls through pointers loaded from data are not followed.
+static DenseSet<FunctionLocation> getRootReachableFunctions(
+    const ObjectFile *Obj, std::map<SectionRef, SectionSymbolsTy> &AllSymbols,
+    std::map<SectionRef, SmallVector<SectionRef, 1>> &SectionRelocMap,
+    const MCDisassembler &DisAsm, const MCInstrAnalysis *MIA) {
+  struct TextSection {
+    SectionRef Section;
+    ArrayRef<uint8_t> Bytes;
+    // Extent of each function, which ends at the next function symbol.
+    std::map<uint64_t, uint64_t> FuncEnds;
+    // Functions referenced by relocations of the section, by offset.
+    std::map<uint64_t, FunctionLocation> RelocTargets;
+  };
+  std::map<uint64_t, TextSection> TextSections;
+  StringMap<FunctionLocation> FuncStarts;
+  for (const SectionRef &Section : ToolSectionFilter(*Obj)) {
+    if (!Section.isText() || Section.isVirtual() || !Section.getSize())
+      continue;
+    StringRef BytesStr =
+        unwrapOrError(Section.getContents(), Obj->getFileName());
+    TextSection &TS = TextSections[Section.getIndex()];
+    TS.Section = Section;
+    TS.Bytes = ArrayRef<uint8_t>(
+        reinterpret_cast<const uint8_t *>(BytesStr.data()), BytesStr.size());
+
+    uint64_t SectionAddr = Section.getAddress();
+    uint64_t SectSize = TS.Bytes.size();
+    for (SymbolInfoTy Sym : AllSymbols[Section]) {
+      uint64_t Start = Sym.Addr - SectionAddr;
+      if (!isAFunctionSymbol(Obj, Sym) || Start >= SectSize)
+        continue;
+      TS.FuncEnds.insert(std::make_pair(Start, SectSize));
+      StringRef Name = Sym.Name;
+      if (Obj->isMachO())
+        Name.consume_front("_");
+      FuncStarts.insert(
+          std::make_pair(Name, std::make_pair(Section.getIndex(), Start)));
+    }
+    for (auto I = TS.FuncEnds.begin(), E = TS.FuncEnds.end(); I != E; ++I) {
+      auto Next = std::next(I);
+      if (Next != E)
+        I->second = Next->first;
+    }
+  }
+
+  for (auto &Entry : TextSections) {
+    TextSection &TS = Entry.second;
+    for (const SectionRef &RelocSec : SectionRelocMap[TS.Section])
+      for (const RelocationRef &Reloc : RelocSec.relocations()) {
+        symbol_iterator Sym = Reloc.getSymbol();
+        if (Sym == Obj->symbol_end())
+          continue;
+        Expected<section_iterator> SymSec = Sym->getSection();
+        Expected<uint64_t> SymAddr = Sym->getAddress();
+        if (!SymSec || !SymAddr) {
+          consumeError(SymSec.takeError());
+          consumeError(SymAddr.takeError());
+          continue;
+        }
+        if (*SymSec == Obj->section_end())
+          continue;
+        auto Target = TextSections.find((*SymSec)->getIndex());
+        if (Target == TextSections.end())
+          continue;
+        uint64_t Offset = *SymAddr - (*SymSec)->getAddress();
+        if (Target->second.FuncEnds.count(Offset))
+          TS.RelocTargets[Reloc.getOffset()] =
+              std::make_pair(Target->first, Offset);
+      }
+  }
+
+  DenseSet<FunctionLocation> Reachable;
+  SmallVector<FunctionLocation, 64> Worklist;
+  auto AddFunction = [&](FunctionLocation Loc) {
+    auto TS = TextSections.find(Loc.first);
+    if (TS != TextSections.end() && TS->second.FuncEnds.count(Loc.second) &&
+        Reachable.insert(Loc).second)
+      Worklist.push_back(Loc);
+  };
+  // Add the function starting at address Addr, referenced from text section
+  // TS. Text sections of relocatable objects all start at address 0, so
+  // addresses there only refer to the referencing section.
+  auto AddFunctionAt = [&](const TextSection &TS, uint64_t Addr) {
+    if (Obj->isRelocatableObject()) {
+      AddFunction(std::make_pair(TS.Section.getIndex(),
+                                 Addr - TS.Section.getAddress()));
+      return;
+    }
+    for (auto &Entry : TextSections) {
+      uint64_t SectionAddr = Entry.second.Section.getAddress();
+      if (Addr >= SectionAddr && Addr - SectionAddr < Entry.second.Bytes.size())
+        AddFunction(std::make_pair(Entry.first, Addr - SectionAddr));
+    }
+  };
+  for (const std::string &Root : Roots) {
+    auto F = FuncStarts.find(Root);
+    if (F == FuncStarts.end())
+      WithColor::warning(errs(), ToolName)
+          << "root function '" << Root << "' not found in "
+          << Obj->getFileName() << "\n";
+    else
+      AddFunction(F->second);
+  }
+
+  raw_null_ostream CommentStream;
+  while (!Worklist.empty()) {
+    FunctionLocation Loc = Worklist.pop_back_val();
+    const TextSection &TS = TextSections[Loc.first];
+    uint64_t SectionAddr = TS.Section.getAddress();
+    uint64_t End = TS.FuncEnds.find(Loc.second)->second;
+    uint64_t Size;
+    for (uint64_t Index = Loc.second; Index < End; Index += Size) {
+      MCInst Inst;
+      if (!DisAsm.getInstruction(Inst, Size, TS.Bytes.slice(Index),
+                                 SectionAddr + Index, CommentStream))
+        Size = 0;
+      if (Size == 0) {
+        Size = 1;
+        continue;
+      }
+
+      uint64_t Target;
+      if ((MIA->isCall(Inst) || MIA->isBranch(Inst)) &&
+          MIA->evaluateBranch(Inst, SectionAddr + Index, Size, Target))
+        AddFunctionAt(TS, Target);
+      if (Optional<uint64_t> Addr = MIA->evaluateMemoryOperandAddress(
+              Inst, SectionAddr + Index, Size))
+        AddFunctionAt(TS, *Addr);
+      // Function addresses are not known in relocatable objects.
+      if (!Obj->isRelocatableObject())
+        for (const MCOperand &Op : Inst)
+          if (Op.isImm())
+            AddFunctionAt(TS, static_cast<uint64_t>(Op.getImm()));
+      for (auto R = TS.RelocTargets.lower_bound(Index),
+                RE = TS.RelocTargets.lower_bound(Index + Size);
+           R != RE; ++R)
+        AddFunction(R->second);
+    }
+  }
+  return Reachable;
+}
+
 namespace RaiserContext {
 SmallVector<ModuleRaiser *, 4> ModuleRaiserRegistry;
 
@@ -830,6 +1253,25 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
   if (StartAddress > StopAddress)
     error("Start address should be less than stop address");
 
+  // Function addresses are loaded from literal pools on ARM and built by
+  // auipc/addi pairs on RISC-V, which --roots does not follow. Functions
+  // only referenced by address would be left out.
+  if (!Roots.empty()) {
+    switch (Obj->getArch()) {
+    case Triple::arm:
+    case Triple::armeb:
+    case Triple::thumb:
+    case Triple::thumbeb:
+    case Triple::riscv32:
+    case Triple::riscv64:
+      report_error(Obj->getFileName(),
+                   "--roots is not supported for " +
+                       Triple::getArchTypeName(Obj->getArch()) + " binaries");
+    default:
+      break;
+    }
+  }
+
   // const Target *TheTarget = MCContext(Obj);
   const Target *TheTarget = getTarget(Obj);
   // Package up features to be passed to target/subtarget
@@ -898,9 +1340,20 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
   /* Set datalayout of the module to be the same as LLVMTargetMachine */
   module.setDataLayout(Target->createDataLayout());
   machineModuleInfo->doInitialization(module);
-  // Initialize all module raisers that are supported and are part of current
-  // LLVM build.
-  ModuleRaiser::InitializeAllModuleRaisers();
+  // Initialize the module raisers of the target of the binary being raised.
+  // A module raiser is set up for a single object, so delete them once it is
+  // raised. They refer to llvmCtx, which outlives this scope guard.
+  auto DeleteModuleRaisers = make_scope_exit([]() {
+    for (ModuleRaiser *MR : RaiserContext::ModuleRaiserRegistry)
+      delete MR;
+    RaiserContext::ModuleRaiserRegistry.clear();
+  });
+  const Triple &TargetTriple = Target->getTargetTriple();
+  if (!ModuleRaiser::InitializeModuleRaisers(
+          getTargetBackendName(TargetTriple.getArch())))
+    report_error(Obj->getFileName(), "Support for raising " +
+                                         TargetTriple.getArchName() +
+                                         " not included");
   // Get the module raiser for Target of the binary being raised
   ModuleRaiser *moduleRaiser = RaiserContext::getModuleRaiser(Target.get());
   assert((moduleRaiser != nullptr) && "Failed to build module raiser");
@@ -909,6 +1362,14 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
                                     &machineModuleInfo->getMMI(), MIA.get(),
                                     MII.get(), Obj, DisAsm.get());
 
+  if (AddressDebugInfo)
+    moduleRaiser->enableAddressDebugInfo();
+
+  // Cached functions carry no address debug information.
+  if (!RaisedFunctionCacheDir.empty() && !AddressDebugInfo)
+    moduleRaiser->enableRaisedFunctionCache(
+        RaisedFunctionCacheDir, getRaisedFunctionCacheToolContext());
+
   // Collect dynamic relocations.
   moduleRaiser->collectDynamicRelocations();
 
@@ -996,6 +1457,12 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
   for (std::pair<const SectionRef, SectionSymbolsTy> &SecSyms : AllSymbols)
     array_pod_sort(SecSyms.second.begin(), SecSyms.second.end());
 
+  // Functions of all text sections reachable from the --roots functions.
+  DenseSet<FunctionLocation> RootReachableFuncs;
+  if (!Roots.empty())
+    RootReachableFuncs = getRootReachableFunctions(
+        Obj, AllSymbols, SectionRelocMap, *DisAsm, MIA.get());
+
   for (const SectionRef &Section : ToolSectionFilter(*Obj)) {
     if ((!Section.isText() || Section.isVirtual()))
       continue;
@@ -1096,6 +1563,10 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
     std::set<uint64_t> branchTargetSet;
     MachineFunctionRaiser *curMFRaiser = nullptr;
 
+    // With --roots, raise only the functions reachable from the roots. The
+    // bytes of symbols following a skipped function are skipped as well.
+    bool SkipSymbolBytes = false;
+
     // Disassemble symbol by symbol.
     LLVM_DEBUG(dbgs() << "BEGIN Disassembly of Functions in Section : "
                       << SectionName.data() << "\n");
@@ -1154,7 +1625,8 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
                 SymStr, FunctionFilter::FILTER_EXCLUDE);
             if (FI != nullptr) {
               // Record the function start index.
-              FI->StartIdx = Start;
+              FuncFilter->setStartIndex(*FI, Start,
+                                        FunctionFilter::FILTER_EXCLUDE);
               continue;
             }
           }
@@ -1165,6 +1637,13 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
             continue;
         }
 
+        FunctionLocation Loc(Section.getIndex(), Start);
+        if (!Roots.empty() && !RootReachableFuncs.count(Loc)) {
+          SkipSymbolBytes = true;
+          continue;
+        }
+        SkipSymbolBytes = false;
+
         LLVM_DEBUG(dbgs() << "check::" << SymStr << "\n");
         // If Symbol is in the ELFCRTSymbol list return this is a symbol of a
         // function we are not interested in disassembling and raising.
@@ -1214,7 +1693,7 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
         curMFRaiser = moduleRaiser->getCurrentMachineFunctionRaiser();
         // assert(curMFRaiser != nullptr && "Current Machine Function Raiser not
         // initialized");
-        if (curMFRaiser == nullptr) {
+        if (curMFRaiser == nullptr || SkipSymbolBytes) {
           // At this point in the instruction stream, we do not have a function
           // symbol to which the bytes being parsed can be made part of. So skip
           // parsing the bytes of this symbol.
@@ -1420,7 +1899,28 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
     for (auto target : branchTargetSet)
       curMFRaiser->getMCInstRaiser()->addTarget(target);
 
-    moduleRaiser->runMachineFunctionPasses();
+    moduleRaiser->runMachineFunctionPasses(ReleaseMachineFunctions);
+
+    moduleRaiser->promoteIndirectCalls();
+
+    // A filtered or --roots raise yields part of the program, which is
+    // expected to be linked with the rest of it. Keep the linkage of raised
+    // functions then.
+    if (FilterFunctionSet.getNumOccurrences() == 0 && Roots.empty())
+      moduleRaiser->internalizeRaisedFunctions();
+
+    // Mark tail calls once calling conventions are final.
+    moduleRaiser->markTailCalls();
+
+    moduleRaiser->inferFunctionAttributes();
+
+    if (!BranchProfile::empty())
+      moduleRaiser->setFunctionEntryCounts();
+
+    moduleRaiser->finalizeAddressDebugInfo();
+
+    if (OptLevel != '0')
+      moduleRaiser->optimizeRaisedFunctions(OptLevel - '0', errs());
 
     if (!FuncFilter->isFilterSetEmpty(FunctionFilter::FILTER_INCLUDE)) {
       errs() << "***** WARNING: The following include filter symbol(s) are not "
@@ -1429,6 +1929,19 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
     }
   }
 
+  // In whole-program mode, make the raised functions callable from objects
+  // raised later and keep the module to be linked with the rest of the
+  // program.
+  if (WholeProgram) {
+    moduleRaiser->prepareForProgramLink();
+    ExternalFunctions::addRaisedFuncPrototypes(module);
+    WholeProgramBitcode.push_back(std::string());
+    raw_string_ostream BitcodeOS(WholeProgramBitcode.back());
+    WriteBitcodeToFile(module, BitcodeOS);
+    BitcodeOS.flush();
+    return;
+  }
+
   // Add the pass manager
   Triple TheTriple = Triple(TripleName);
 
@@ -1444,6 +1957,11 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
 
   raw_pwrite_stream *OS = &Out->os();
 
+  if (OutputFormat == ROF_Asm || OutputFormat == ROF_Obj) {
+    compileRaisedModule(module, *OS);
+    return;
+  }
+
   legacy::PassManager PM;
 
   LLVMTargetMachine &LLVMTM = static_cast<LLVMTargetMachine &>(*Target);
@@ -1461,7 +1979,7 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
     PM.add(machineModuleInfo);
 
     // Add print pass to emit ouptut file.
-    PM.add(new EmitRaisedOutputPass(*OS, OutputFormat));
+    PM.add(new EmitRaisedOutputPass(*OS, getIRFileType()));
 
     TPC.printAndVerify("");
     for (const std::string &RunPassName : *RunPassNames) {
@@ -1472,7 +1990,7 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
     TPC.setInitialized();
   } else if (Target->addPassesToEmitFile(
                  PM, *OS, nullptr, /* no dwarf output file stream*/
-                 OutputFormat, NoVerify, machineModuleInfo)) {
+                 getIRFileType(), NoVerify, machineModuleInfo)) {
     outs() << ToolName << "run system pass!\n";
   }
 
@@ -1563,6 +2081,134 @@ static void DumpInput(StringRef file) {
     report_error(errorCodeToError(object_error::invalid_file_type), file);
 }
 
+/// @brief Append the names of the shared libraries recorded as DT_NEEDED in
+/// the dynamic section of \a Obj to \a Needed.
+template <class ELFT>
+static void getNeededLibraries(const ELFObjectFile<ELFT> *Obj,
+                               std::vector<std::string> &Needed) {
+  const ELFFile<ELFT> &EF = Obj->getELFFile();
+  auto DynEntriesOrErr = EF.dynamicEntries();
+  if (!DynEntriesOrErr)
+    report_error(DynEntriesOrErr.takeError(), Obj->getFileName());
+
+  uint64_t StrTabAddr = 0;
+  uint64_t StrTabSize = 0;
+  std::vector<uint64_t> NeededOffsets;
+  for (const auto &Dyn : *DynEntriesOrErr) {
+    if (Dyn.d_tag == ELF::DT_STRTAB)
+      StrTabAddr = Dyn.getPtr();
+    else if (Dyn.d_tag == ELF::DT_STRSZ)
+      StrTabSize = Dyn.getVal();
+    else if (Dyn.d_tag == ELF::DT_NEEDED)
+      NeededOffsets.push_back(Dyn.getVal());
+  }
+  if (NeededOffsets.empty())
+    return;
+
+  auto StrTabOrErr = EF.toMappedAddr(StrTabAddr);
+  if (!StrTabOrErr)
+    report_error(StrTabOrErr.takeError(), Obj->getFileName());
+  StringRef StrTab(reinterpret_cast<const char *>(*StrTabOrErr), StrTabSize);
+  for (uint64_t Offset : NeededOffsets) {
+    if (Offset >= StrTab.size())
+      report_error(Obj->getFileName(), "invalid DT_NEEDED entry");
+    Needed.push_back(StrTab.drop_front(Offset).data());
+  }
+}
+
+static void getNeededLibraries(StringRef File,
+                               std::vector<std::string> &Needed) {
+  Expected<OwningBinary<Binary>> BinaryOrErr = createBinary(File);
+  if (!BinaryOrErr)
+    report_error(BinaryOrErr.takeError(), File);
+  Binary *Bin = BinaryOrErr.get().getBinary();
+
+  if (auto *Obj = dyn_cast<ELF64LEObjectFile>(Bin))
+    getNeededLibraries(Obj, Needed);
+  else if (auto *Obj = dyn_cast<ELF32LEObjectFile>(Bin))
+    getNeededLibraries(Obj, Needed);
+  else
+    report_error(File, "--whole-program supports only ELF binaries");
+}
+
+/// @brief Return the path of shared library \a Name in the library search
+/// paths or the directory of \a Exe, or an empty string if it is not found.
+static std::string findLibrary(StringRef Name, StringRef Exe) {
+  std::vector<std::string> Dirs(LibrarySearchPaths.begin(),
+                                LibrarySearchPaths.end());
+  Dirs.push_back(std::string(sys::path::parent_path(Exe)));
+  for (const std::string &Dir : Dirs) {
+    SmallString<128> Path(Dir);
+    sys::path::append(Path, Name);
+    if (sys::fs::is_regular_file(Path))
+      return std::string(Path);
+  }
+  return std::string();
+}
+
+/// @brief Raise executable \a Exe and the shared libraries it transitively
+/// needs that are found locally, and emit them as a single linked module.
+static void DumpWholeProgram(StringRef Exe) {
+  // Collect the libraries breadth-first. Libraries that are not found, such
+  // as the C library, remain external to the raised program.
+  std::vector<std::string> Libs;
+  std::set<std::string> Seen;
+  std::vector<std::string> Needed;
+  getNeededLibraries(Exe, Needed);
+  for (size_t I = 0; I < Needed.size(); ++I) {
+    if (!Seen.insert(Needed[I]).second)
+      continue;
+    std::string Path = findLibrary(Needed[I], Exe);
+    if (Path.empty()) {
+      LLVM_DEBUG(dbgs() << "Not raising library " << Needed[I]
+                        << " : not found in library search paths\n");
+      continue;
+    }
+    Libs.push_back(Path);
+    getNeededLibraries(Path, Needed);
+  }
+
+  // Raise libraries before the objects that need them, so that calls through
+  // the PLT find the prototypes of the raised library functions.
+  std::for_each(Libs.rbegin(), Libs.rend(),
+                [](const std::string &Lib) { DumpInput(Lib); });
+  DumpInput(Exe);
+
+  // Link the library modules into that of the executable. This resolves the
+  // declarations of library functions to their raised definitions.
+  LLVMContext Ctx;
+  auto LoadModule = [&Ctx](const std::string &Bitcode) {
+    Expected<std::unique_ptr<Module>> ModOrErr =
+        parseBitcodeFile(MemoryBufferRef(Bitcode, "raised-module"), Ctx);
+    if (!ModOrErr)
+      report_error(ModOrErr.takeError(), "raised-module");
+    return std::move(*ModOrErr);
+  };
+  std::unique_ptr<Module> Program = LoadModule(WholeProgramBitcode.back());
+  Linker L(*Program);
+  for (size_t I = 0; I + 1 < WholeProgramBitcode.size(); ++I)
+    if (L.linkInModule(LoadModule(WholeProgramBitcode[I])))
+      report_error(Libs[Libs.size() - 1 - I], "Failed to link raised module");
+  WholeProgramBitcode.clear();
+
+  std::unique_ptr<ToolOutputFile> Out =
+      GetOutputStream(nullptr, Triple::UnknownOS, ToolName.data());
+  if (!Out)
+    return;
+
+  // Keep the file created.
+  Out->keep();
+
+  if (OutputFormat == ROF_Asm || OutputFormat == ROF_Obj) {
+    compileRaisedModule(*Program, Out->os());
+    return;
+  }
+
+  legacy::PassManager PM;
+  PM.add(new EmitRaisedOutputPass(Out->os(), getIRFileType()));
+  PM.run(*Program);
+}
+
 int main(int argc, char **argv) {
   // Print a stack trace if we signal out.
   cout << "hello cyc" << endl;
@@ -1570,14 +2216,12 @@ int main(int argc, char **argv) {
   PrettyStackTraceProgram X(argc, argv);
   llvm_shutdown_obj Y; // Call llvm_shutdown() on exit.
 
-  // Initialize targets and assembly printers/parsers.
-  llvm::InitializeAllTargets();
-  llvm::InitializeAllTargetInfos();
-  llvm::InitializeAllTargetMCs();
-  llvm::InitializeAllDisassemblers();
-
-  // Register the target printer for --version.
-  cl::AddExtraVersionPrinter(TargetRegistry::printRegisteredTargetsForVersion);
+  // Targets are initialized once the architecture of the input is known.
+  // Register the target printer for --version, which lists all of them.
+  cl::AddExtraVersionPrinter([](raw_ostream &OS) {
+    llvm::InitializeAllTargetInfos();
+    TargetRegistry::printRegisteredTargetsForVersion(OS);
+  });
 
   cl::HideUnrelatedOptions(LLVMMCToLLCategory);
 
@@ -1594,17 +2238,32 @@ int main(int argc, char **argv) {
                                 IncludeFileNames.end());
   std::vector<string> InclFNames(InclFNameSet.begin(), InclFNameSet.end());
   if (!InclFNames.empty()) {
-    if (!ExternalFunctions::getUserSpecifiedFuncPrototypes(InclFNames)) {
+    if (!ExternalFunctions::getUserSpecifiedFuncPrototypes(InclFNames,
+                                                           PrototypeDB)) {
       dbgs() << "Unable to read external function prototype. Ignoring\n";
     }
   }
 
+  if (OptLevel < '0' || OptLevel > '3')
+    report_error(ToolName, "invalid optimization level -O" +
+                               Twine(static_cast<char>(OptLevel)));
+
+  // Read control transfer counts of the input binary
+  if (!ProfileFile.empty() && !BranchProfile::readProfile(ProfileFile))
+    report_error(ProfileFile, "Unable to read profile");
+
   // Disassemble contents of .text section.
   Disassemble = true;
   FilterSections.addValue(".text");
 
   llvm::setCurrentDebugType(DEBUG_TYPE);
-  std::for_each(InputFilenames.begin(), InputFilenames.end(), DumpInput);
+  if (WholeProgram) {
+    if (InputFilenames.size() != 1)
+      report_error(InputFilenames[0],
+                   "--whole-program expects a single executable");
+    DumpWholeProgram(InputFilenames[0]);
+  } else
+    std::for_each(InputFilenames.begin(), InputFilenames.end(), DumpInput);
 
   return EXIT_SUCCESS;
 }
@@ -9,6 +9,7 @@
 #ifndef LLVM_TOOLS_LLVM_MCTOLL_LLVM_MCTOLL_H
 #define LLVM_TOOLS_LLVM_MCTOLL_LLVM_MCTOLL_H
 
+#include "llvm/ADT/Triple.h"
 #include "llvm/DebugInfo/DIContext.h"
 #include "llvm/Object/Archive.h"
 #include "llvm/Support/CommandLine.h"
@@ -45,6 +46,7 @@ void error(std::error_code ec);
 void error(Error E);
 bool isRelocAddressLess(object::RelocationRef A, object::RelocationRef B);
 bool RelocAddressLess(object::RelocationRef a, object::RelocationRef b);
+void initializeTarget(Triple::ArchType Arch);
 void parseInputMachO(StringRef Filename);
 void printCOFFUnwindInfo(const object::COFFObjectFile *o);
 void printMachOUnwindInfo(const object::MachOObjectFile *o);
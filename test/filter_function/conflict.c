@@ -0,0 +1,22 @@
+// REQUIRES: system-linux
+// RUN: clang --target=x86_64-linux -o conflict %s
+// RUN: llvm-mctoll -d conflict --filter-functions-file=%p/filters-conflict.txt 2>&1 | FileCheck %s --check-prefix=WARN
+// RUN: cat conflict-dis.ll | FileCheck %s
+// WARN: cold_mul is both in tables exclude-functions and include-functions
+// WARN-NOT: include filter symbol(s) are not found
+// CHECK-DAG: declare dso_local i32 @cold_mul(i32, i32)
+// CHECK-DAG: declare dso_local i32 @hot_sub(i32, i32)
+// CHECK-DAG: define dso_local i32 @hot_add(i32 %arg1, i32 %arg2)
+// CHECK-DAG: define dso_local i32 @main()
+
+int hot_add(int a, int b) { return a + b; }
+
+int hot_sub(int a, int b) { return a - b; }
+
+int cold_mul(int a, int b) { return a * b; }
+
+int main() {
+  int c = hot_add(5, 2);
+  c = hot_sub(c, 3);
+  return cold_mul(c, 4);
+}
@@ -0,0 +1,24 @@
+// REQUIRES: system-linux
+// RUN: clang --target=x86_64-linux -o pattern %s
+// RUN: llvm-mctoll -d pattern --filter-functions-file=%p/filters-pattern.txt
+// RUN: cat pattern-dis.ll | FileCheck %s
+// CHECK-DAG: declare dso_local i32 @cold_mul(i32, i32)
+// CHECK-DAG: declare dso_local i32 @cold_div(i32, i32)
+// CHECK-DAG: define dso_local i32 @hot_add(i32 %arg1, i32 %arg2)
+// CHECK-DAG: define dso_local i32 @hot_sub(i32 %arg1, i32 %arg2)
+// CHECK-DAG: define dso_local i32 @main()
+
+int hot_add(int a, int b) { return a + b; }
+
+int hot_sub(int a, int b) { return a - b; }
+
+int cold_mul(int a, int b) { return a * b; }
+
+int cold_div(int a, int b) { return a / b; }
+
+int main() {
+  int c = hot_add(5, 2);
+  c = hot_sub(c, 3);
+  c = cold_mul(c, 4);
+  return cold_div(c, 2);
+}
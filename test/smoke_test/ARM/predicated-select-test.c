@@ -0,0 +1,18 @@
+// RUN: clang %S/../Inputs/predicated.c -O2 -o %t.so --target=%arm_triple -fuse-ld=lld -shared
+// RUN: llvm-mctoll -d %t.so
+// RUN: clang -o %t1 %s %t-dis.ll -mx32
+// RUN: %t1 2>&1 | FileCheck %s
+// CHECK: clamp_add(1, 2) = 2
+// CHECK-NEXT: clamp_add(90, 20) = 10
+// CHECK-NEXT: clamp_add(2, 1) = 3
+
+#include <stdio.h>
+
+extern int clamp_add(int a, int b);
+
+int main() {
+  printf("clamp_add(1, 2) = %d\n", clamp_add(1, 2));
+  printf("clamp_add(90, 20) = %d\n", clamp_add(90, 20));
+  printf("clamp_add(2, 1) = %d\n", clamp_add(2, 1));
+  return 0;
+}
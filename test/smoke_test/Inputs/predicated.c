@@ -0,0 +1,8 @@
+int clamp_add(int a, int b) {
+  int r = a + b;
+  if (r > 100)
+    r = r - 100;
+  if (a < b)
+    r = r ^ 1;
+  return r;
+}
@@ -0,0 +1 @@
+int scale(int a) { return a * 3; }
@@ -0,0 +1,3 @@
+static int __attribute__((noinline)) helper(int a) { return a * 3; }
+
+int scale(int a) { return helper(a); }
@@ -0,0 +1,24 @@
+// REQUIRES: system-linux
+// RUN: clang -o %t %s -O2
+// RUN: llvm-mctoll -d -I /usr/include/stdio.h --address-debug-info %t
+// RUN: FileCheck %s --check-prefix=IR < %t-dis.ll
+// RUN: clang -o %t1 %t-dis.ll
+// RUN: %t1 2>&1 | FileCheck %s
+// IR: define {{.*}}@negate(i32 %arg1) {{.*}}!dbg [[NEGATE:![0-9]+]]
+// IR-DAG: !DICompileUnit(language: DW_LANG_C, {{.*}}producer: "llvm-mctoll", {{.*}}emissionKind: LineTablesOnly
+// IR-DAG: [[NEGATE]] = distinct !DISubprogram(name: "negate", {{.*}}line: [[NEGATE_ADDR:[0-9]+]]
+// IR-DAG: !DILocation(line: [[NEGATE_ADDR]], scope: [[NEGATE]])
+// CHECK: Negated 2 is -2
+
+/* Raised instructions carry the address of the input binary instruction they
+   originate from as line number.
+ */
+
+#include <stdio.h>
+
+int __attribute__((noinline)) negate(int a) { return -a; }
+
+int main(int argc, char **argv) {
+  printf("Negated %d is %d\n", argc + 1, negate(argc + 1));
+  return 0;
+}
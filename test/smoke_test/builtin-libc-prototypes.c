@@ -0,0 +1,26 @@
+// REQUIRES: system-linux
+// RUN: clang -o %t %s -O2
+// RUN: llvm-mctoll -d %t
+// RUN: FileCheck %s --check-prefix=IR < %t-dis.ll
+// RUN: clang -o %t1 %t-dis.ll
+// RUN: %t1 2>&1 | FileCheck %s
+// IR-DAG: declare {{.*}}i32 @printf(i8*, ...)
+// IR-DAG: declare {{.*}}i8* @malloc(i32)
+// IR-DAG: declare {{.*}}i8* @strcpy(i8*, i8*)
+// CHECK: Built-in prototypes 5
+
+/* The binary is raised without include files, using the built-in prototypes
+   of the C library functions it calls.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main(int argc, char **argv) {
+  char *s = malloc(16);
+  strcpy(s, argv[0]);
+  printf("Built-in prototypes %d\n", (int)strlen("hello"));
+  free(s);
+  return 0;
+}
@@ -0,0 +1,24 @@
+// REQUIRES: system-linux
+// RUN: clang -o %t %s -O2
+// RUN: llvm-mctoll -d -I /usr/include/stdio.h %t
+// RUN: FileCheck %s --check-prefix=IR < %t-dis.ll
+// RUN: clang -o %t1 %t-dis.ll
+// RUN: %t1 2>&1 | FileCheck %s
+// IR: define {{.*}}@cube(i32 %arg1) [[CUBE_ATTRS:#[0-9]+]]
+// IR-DAG: declare {{.*}}@printf(i8*, ...) [[PRINTF_ATTRS:#[0-9]+]]
+// IR-DAG: attributes [[CUBE_ATTRS]] = {{.*}}nounwind
+// IR-DAG: attributes [[PRINTF_ATTRS]] = {{.*}}nounwind
+// CHECK: Cube of 3 27
+
+/* Raised leaf functions and known library functions are annotated with the
+   attributes inferred for them.
+ */
+
+#include <stdio.h>
+
+int __attribute__((noinline)) cube(int a) { return a * a * a; }
+
+int main(int argc, char **argv) {
+  printf("Cube of %d %d\n", argc + 2, cube(argc + 2));
+  return 0;
+}
@@ -0,0 +1,28 @@
+// REQUIRES: system-linux
+// RUN: clang -o %t %s -O0
+// RUN: llvm-mctoll -d -I /usr/include/stdio.h %t
+// RUN: FileCheck %s --check-prefix=IR < %t-dis.ll
+// RUN: clang -o %t1 %t-dis.ll
+// RUN: %t1 2>&1 | FileCheck %s
+// IR: define internal fastcc i32 @square(i32 %arg1)
+// IR: define internal fastcc i32 @sum_squares(i32 %arg1, i32 %arg2)
+// IR: define dso_local i32 @main()
+// CHECK: Sum of squares 25
+
+/* Functions of an executable that are neither dynamically exported nor
+   address-taken are raised with internal linkage and the fast calling
+   convention.
+ */
+
+#include <stdio.h>
+
+int __attribute__((noinline)) square(int a) { return a * a; }
+
+int __attribute__((noinline)) sum_squares(int a, int b) {
+  return square(a) + square(b);
+}
+
+int main() {
+  printf("Sum of squares %d\n", sum_squares(3, 4));
+  return 0;
+}
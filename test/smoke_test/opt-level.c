@@ -0,0 +1,26 @@
+// REQUIRES: system-linux
+// RUN: clang -o %t %s -O2
+// RUN: llvm-mctoll -d -I /usr/include/stdio.h -O2 %t 2>&1 | FileCheck %s --check-prefix=REPORT
+// RUN: clang -o %t1 %t-dis.ll
+// RUN: %t1 2>&1 | FileCheck %s
+// REPORT: -O2: {{[0-9]+}} -> {{[0-9]+}} instructions, {{[0-9]+}} -> {{[0-9]+}} blocks in
+// CHECK: Counted 4 set bits
+
+/* The raised functions are cleaned up by the -O2 pipeline before they are
+   written, and the change in their size is reported. */
+
+#include <stdio.h>
+
+int __attribute__((noinline)) count_bits(unsigned v) {
+  int count = 0;
+  while (v) {
+    count += v & 1;
+    v >>= 1;
+  }
+  return count;
+}
+
+int main() {
+  printf("Counted %d set bits\n", count_bits(0x2d));
+  return 0;
+}
@@ -0,0 +1,26 @@
+// REQUIRES: system-linux
+// RUN: clang -o %t %s -O2
+// RUN: llvm-mctoll -d -I /usr/include/stdio.h --output-format=obj %t
+// RUN: clang -o %t1 %t-dis.o
+// RUN: %t1 2>&1 | FileCheck %s
+// RUN: llvm-mctoll -d -I /usr/include/stdio.h --output-format=asm --passes='default<O1>' %t -o %t-dis.s
+// RUN: clang -o %t2 %t-dis.s
+// RUN: %t2 2>&1 | FileCheck %s
+// CHECK: Sum of squares to 10 is 385
+
+/* The raised module is optimized and compiled to a native object or assembly
+   file in-process. */
+
+#include <stdio.h>
+
+int __attribute__((noinline)) sum_squares(int n) {
+  int sum = 0;
+  for (int i = 1; i <= n; i++)
+    sum += i * i;
+  return sum;
+}
+
+int main() {
+  printf("Sum of squares to 10 is %d\n", sum_squares(10));
+  return 0;
+}
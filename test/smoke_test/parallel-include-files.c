@@ -0,0 +1,26 @@
+// REQUIRES: system-linux
+// RUN: clang -o %t %s -O2
+// RUN: llvm-mctoll -d -I /usr/include/stdio.h -I /usr/include/stdlib.h -I /usr/include/string.h %t
+// RUN: FileCheck %s --check-prefix=IR < %t-dis.ll
+// RUN: clang -o %t1 %t-dis.ll
+// RUN: %t1 2>&1 | FileCheck %s
+// IR-DAG: declare {{.*}}i32 @puts(i8*)
+// IR-DAG: declare {{.*}}i32 @atoi(i8*)
+// IR-DAG: declare {{.*}}i32 @strcmp(i8*, i8*)
+// CHECK: 42 equal
+
+/* The include files are parsed concurrently. The prototypes of the functions
+   called are found whichever include file is parsed first.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main(int argc, char **argv) {
+  char buf[16];
+  sprintf(buf, "%d", atoi(argc > 5 ? argv[1] : "42"));
+  printf("%s ", buf);
+  puts(strcmp(buf, "42") == 0 ? "equal" : "different");
+  return 0;
+}
@@ -0,0 +1,69 @@
+// REQUIRES: system-linux
+// RUN: clang -o %t %s -O2
+// RUN: objdump -d --no-show-raw-insn %t | awk '/^[0-9a-f]+ <check>:/ { f = 1; next } /^$/ { f = 0 } f && B { sub(":", "", $1); print "0x" B " 0x" T " 3"; print "0x" B " 0x" $1 " 9"; B = ""; f = 0 } f && $2 ~ /^j/ && $2 != "jmp" { sub(":", "", $1); B = $1; T = $3 }' > %t.prof
+// RUN: objdump -d --no-show-raw-insn %t | awk 'BEGIN { C["<zero>"] = 10; C["<one>"] = 20; C["<two>"] = 30; C["<three>"] = 40; C["<four>"] = 50 } /^[0-9a-f]+ <dispatch>:/ { f = 1; next } /^$/ { f = 0 } f && $2 == "jmp" && $4 in C { sub(":", "", $1); print "0x0 0x" $1 " " C[$4] }' >> %t.prof
+// RUN: llvm-mctoll -d -I /usr/include/stdio.h --profile=%t.prof %t
+// RUN: FileCheck %s --check-prefix=IR < %t-dis.ll
+// RUN: clang -o %t1 %t-dis.ll
+// RUN: %t1 2>&1 | FileCheck %s
+// IR-LABEL: define {{.*}}@check(
+// IR: br i1 {{.*}}, !prof [[CHECK_WEIGHTS:![0-9]+]]
+// IR-LABEL: define {{.*}}@dispatch(
+// IR: ], !prof [[DISPATCH_WEIGHTS:![0-9]+]]
+// IR: [[CHECK_WEIGHTS]] = !{!"branch_weights", i32 3, i32 9}
+// IR: [[DISPATCH_WEIGHTS]] = !{!"branch_weights", i32 0, i32 10, i32 20, i32 30, i32 40, i32 50}
+// CHECK: check(1) = 2
+// CHECK-NEXT: check(201) = 402
+// CHECK-NEXT: zero
+// CHECK-NEXT: one
+// CHECK-NEXT: two
+// CHECK-NEXT: three
+// CHECK-NEXT: four
+
+/* The profile records 3 transfers to the target of the conditional branch of
+   check() and 9 to the instruction following it, which weigh the raised
+   branch in that order. It also records the transfers to each case of the
+   jump table of dispatch(), which weigh the cases of the raised switch after
+   its default destination, which is never reached.
+ */
+
+#include <stdio.h>
+
+int __attribute__((noinline)) big(int n) { return n * 2; }
+
+int __attribute__((noinline)) check(int n) {
+  if (n > 100)
+    return big(n);
+  return n + 1;
+}
+
+int __attribute__((noinline)) zero(void) { return puts("zero"); }
+int __attribute__((noinline)) one(void) { return puts("one"); }
+int __attribute__((noinline)) two(void) { return puts("two"); }
+int __attribute__((noinline)) three(void) { return puts("three"); }
+int __attribute__((noinline)) four(void) { return puts("four"); }
+
+int __attribute__((noinline)) dispatch(int n) {
+  switch (n) {
+  case 0:
+    return zero();
+  case 1:
+    return one();
+  case 2:
+    return two();
+  case 3:
+    return three();
+  case 4:
+    return four();
+  default:
+    return 0;
+  }
+}
+
+int main(int argc, char **argv) {
+  printf("check(%d) = %d\n", argc, check(argc));
+  printf("check(%d) = %d\n", argc + 200, check(argc + 200));
+  for (int i = 0; i < 6; i++)
+    dispatch(i);
+  return 0;
+}
@@ -0,0 +1,23 @@
+// REQUIRES: system-linux
+// RUN: clang -o %t %s -O2
+// RUN: nm %t | awk '$3 == "twice" { print "0x0 0x" $1 " 7" }' > %t.prof
+// RUN: llvm-mctoll -d -I /usr/include/stdio.h --profile=%t.prof %t
+// RUN: FileCheck %s --check-prefix=IR < %t-dis.ll
+// RUN: clang -o %t1 %t-dis.ll
+// RUN: %t1 2>&1 | FileCheck %s
+// IR: define {{.*}}@twice(i32 %arg1) {{.*}}!prof [[ENTRY:![0-9]+]]
+// IR: [[ENTRY]] = !{!"function_entry_count", i64 7}
+// CHECK: Twice 2 is 4
+
+/* Raised functions get the entry count of the control transfers to their
+   start address recorded in the profile.
+ */
+
+#include <stdio.h>
+
+int __attribute__((noinline)) twice(int a) { return a + a; }
+
+int main(int argc, char **argv) {
+  printf("Twice %d is %d\n", argc + 1, twice(argc + 1));
+  return 0;
+}
@@ -0,0 +1,38 @@
+// REQUIRES: system-linux
+// RUN: clang -o %t %s -O2
+// RUN: llvm-mctoll -d -I /usr/include/stdio.h %t
+// RUN: FileCheck %s --check-prefix=IR < %t-dis.ll
+// RUN: clang -o %t1 %t-dis.ll
+// RUN: %t1 2>&1 | FileCheck %s
+// IR-DAG: %is_add = icmp eq i64 %{{[0-9a-z_.]+}}, {{[0-9]+}}
+// IR-DAG: %is_sub = icmp eq i64 %{{[0-9a-z_.]+}}, {{[0-9]+}}
+// IR-DAG: call {{.*}}@add(
+// IR-DAG: call {{.*}}@sub(
+// CHECK: ops[0](7, 3) = 10
+// CHECK: ops[1](7, 3) = 4
+
+/* Calls through a table of function pointers are promoted to direct calls of
+   the functions in the table, guarded by a comparison of the called pointer.
+   The raised table holds the addresses of the functions in the binary, which
+   the called pointer is compared with.
+ */
+
+#include <stdio.h>
+
+typedef int (*binop)(int a, int b);
+
+int __attribute__((noinline)) add(int a, int b) { return a + b; }
+
+int __attribute__((noinline)) sub(int a, int b) { return a - b; }
+
+binop ops[] = {add, sub};
+
+int __attribute__((noinline)) apply(int i, int a, int b) {
+  return ops[i](a, b);
+}
+
+int main(int argc, char **argv) {
+  for (int i = 0; i < 2; i++)
+    printf("ops[%d](7, 3) = %d\n", i, apply(i, 7, 3));
+  return 0;
+}
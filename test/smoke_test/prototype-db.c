@@ -0,0 +1,32 @@
+// REQUIRES: system-linux
+// RUN: clang -o %t %s
+// RUN: rm -f %t.pdb
+// RUN: echo 'typedef const char *text_t;' > %t-text.h
+// RUN: echo '#include "%basename_t-text.h"' > %t.h
+// RUN: echo 'int puts(text_t s);' >> %t.h
+// RUN: llvm-mctoll -d -I %t.h --prototype-db=%t.pdb %t
+// RUN: FileCheck %s --check-prefix=IR < %t-dis.ll
+// RUN: sed -i 's/i32/i16/' %t.pdb
+// RUN: llvm-mctoll -d -I %t.h --prototype-db=%t.pdb %t
+// RUN: FileCheck %s --check-prefix=DB < %t-dis.ll
+// RUN: echo 'typedef long long text_t;' > %t-text.h
+// RUN: llvm-mctoll -d -I %t.h --prototype-db=%t.pdb %t
+// RUN: FileCheck %s --check-prefix=INCLUDE < %t-dis.ll
+// RUN: clang -o %t1 %t-dis.ll
+// RUN: %t1 2>&1 | FileCheck %s
+// IR: declare {{.*}}i32 @puts(i8*)
+// DB: declare {{.*}}i16 @puts(i8*)
+// INCLUDE: declare {{.*}}i32 @puts(i64)
+// CHECK: Hello prototype database!
+
+/* The first run parses the header and records the prototype of puts() in the
+   database. The second one reads it from there, as shown by the return type
+   edited in the database. Changing a type in the file the header includes
+   makes the third run parse the header again.
+ */
+
+#include <stdio.h>
+int main(int argc, char **argv) {
+  puts("Hello prototype database!");
+  return 0;
+}
@@ -0,0 +1,59 @@
+// REQUIRES: system-linux
+// RUN: clang -o %t %s -O2
+// RUN: rm -rf %t-cache
+// RUN: llvm-mctoll -d -I /usr/include/stdio.h --raised-function-cache=%t-cache %t
+// RUN: ls %t-cache | FileCheck %s --check-prefix=CACHE
+// RUN: llvm-mctoll -d -I /usr/include/stdio.h --raised-function-cache=%t-cache %t
+// RUN: FileCheck %s --check-prefix=IR < %t-dis.ll
+// RUN: clang -o %t1 %t-dis.ll
+// RUN: %t1 2>&1 | FileCheck %s
+// RUN: ls %t-cache > %t-entries
+// RUN: clang -o %t2 %s -O2 -DFACTOR=5 -DLIMIT=100000
+// RUN: llvm-mctoll -d -I /usr/include/stdio.h --raised-function-cache=%t-cache %t2
+// RUN: ls %t-cache | not diff %t-entries - | FileCheck %s --check-prefix=NEW
+// RUN: clang -o %t3 %t2-dis.ll
+// RUN: %t3 2>&1 | FileCheck %s --check-prefix=REBUILT
+// CACHE: {{[0-9a-f]+}}.bc
+// IR-DAG: define {{.*}}@main(
+// IR-DAG: define {{.*}}@scale(
+// IR-DAG: define {{.*}}@report(
+// CHECK: scale(7) = 21
+// CHECK-NEXT: scale(-2) = -6
+// NEW-NOT: <
+// NEW: > {{[0-9a-f]+}}.bc
+// NEW-NOT: >
+// REBUILT: scale(7) = 35
+// REBUILT-NEXT: scale(-2) = -10
+
+/* The second raise reuses the functions raised and cached by the first one,
+   which refer to each other, to a library function and to string constants.
+   Rebuilding with another factor and a limit grows scale() only. report()
+   moves along with the displacements of its call and string constant, yet it
+   is still taken from the cache, so only scale() is raised and cached again.
+ */
+
+#include <stdio.h>
+
+#ifndef FACTOR
+#define FACTOR 3
+#endif
+
+long __attribute__((noinline)) scale(long n) {
+#ifdef LIMIT
+  if (n > LIMIT)
+    n = LIMIT;
+  if (n < -LIMIT)
+    n = -LIMIT;
+#endif
+  return n * FACTOR;
+}
+
+void __attribute__((noinline)) report(long n) {
+  printf("scale(%ld) = %ld\n", n, scale(n));
+}
+
+int main() {
+  report(7);
+  report(-2);
+  return 0;
+}
@@ -0,0 +1,26 @@
+// REQUIRES: system-linux
+// RUN: clang -o %t %s -O2
+// RUN: llvm-mctoll -d -I /usr/include/stdio.h --release-machine-functions %t
+// RUN: clang -o %t1 %t-dis.ll
+// RUN: %t1 2>&1 | FileCheck %s
+// CHECK: square(6) = 36
+// CHECK: cube(3) = 27
+// CHECK: halve(9.0) = 4.5
+
+/* The machine-level state of each function is freed as soon as it is
+   raised, without changing the raised module. */
+
+#include <stdio.h>
+
+long __attribute__((noinline)) square(long x) { return x * x; }
+
+long __attribute__((noinline)) cube(long x) { return square(x) * x; }
+
+double __attribute__((noinline)) halve(double x) { return x / 2; }
+
+int main() {
+  printf("square(6) = %ld\n", square(6));
+  printf("cube(3) = %ld\n", cube(3));
+  printf("halve(9.0) = %.1f\n", halve(9.0));
+  return 0;
+}
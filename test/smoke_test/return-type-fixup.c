@@ -0,0 +1,36 @@
+// REQUIRES: system-linux
+// RUN: clang -o %t %s -O2
+// RUN: llvm-mctoll -d -I /usr/include/stdio.h %t
+// RUN: FileCheck %s --check-prefix=IR < %t-dis.ll
+// RUN: clang -o %t1 %t-dis.ll
+// RUN: %t1 2>&1 | FileCheck %s
+// IR-DAG: define {{.*}}void @store(i64* %{{.*}}, i64 %{{.*}})
+// IR-DAG: define {{.*}}void @store_pair(i64* %{{.*}}, i64 %{{.*}})
+// IR-DAG: define {{.*}}void @store_pairs(i64* %{{.*}}, i64 %{{.*}})
+// CHECK: 5 5 6 6
+
+/* store_pair() and store_pairs() end in tail calls, so they return whatever
+   their callee returns. The return types of the raised functions agree once
+   all functions are raised.
+ */
+
+#include <stdio.h>
+
+void __attribute__((noinline)) store(long *p, long v) { *p = v; }
+
+void __attribute__((noinline)) store_pair(long *p, long v) {
+  store(p, v);
+  store(p + 1, v);
+}
+
+void __attribute__((noinline)) store_pairs(long *p, long v) {
+  store_pair(p, v);
+  store_pair(p + 2, v + 1);
+}
+
+int main() {
+  long a[4];
+  store_pairs(a, 5);
+  printf("%ld %ld %ld %ld\n", a[0], a[1], a[2], a[3]);
+  return 0;
+}
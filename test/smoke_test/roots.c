@@ -0,0 +1,32 @@
+// REQUIRES: system-linux
+// RUN: clang -o %t %s -O2
+// RUN: llvm-mctoll -d -I /usr/include/stdio.h --roots=main %t 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=WARN --allow-empty
+// RUN: FileCheck %s --check-prefix=IR < %t-dis.ll
+// RUN: FileCheck %s --check-prefix=UNUSED < %t-dis.ll
+// RUN: clang -o %t1 %t-dis.ll
+// RUN: %t1 2>&1 | FileCheck %s
+// IR-DAG: define {{.*}}@main(
+// IR-DAG: define {{.*}}@twice(
+// IR-DAG: define {{.*}}@add_one(
+// UNUSED-NOT: @unused(
+// WARN-NOT: root function 'main' not found
+// CHECK: twice(add_one(20)) = 42
+
+/* Only main() and the functions it reaches are raised. unused() is not
+   referenced by them and is left out. main() is found once across all text
+   sections, without warnings for the sections that do not define it.
+ */
+
+#include <stdio.h>
+
+long __attribute__((noinline)) unused(long n) { return n * 3; }
+
+long __attribute__((noinline)) add_one(long n) { return n + 1; }
+
+long __attribute__((noinline)) twice(long n) { return add_one(n) * 2 - 2; }
+
+int main() {
+  printf("twice(add_one(20)) = %ld\n", twice(add_one(20)));
+  return 0;
+}
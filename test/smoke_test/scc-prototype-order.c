@@ -0,0 +1,32 @@
+// REQUIRES: system-linux
+// RUN: clang -o %t %s -O2
+// RUN: llvm-mctoll -d -I /usr/include/stdio.h %t
+// RUN: FileCheck %s --check-prefix=IR < %t-dis.ll
+// RUN: clang -o %t1 %t-dis.ll
+// RUN: %t1 2>&1 | FileCheck %s
+// IR-DAG: define {{.*}}i64 @leaf(i64 %{{.*}})
+// IR-DAG: define {{.*}}i64 @middle(i64 %{{.*}})
+// IR-DAG: define {{.*}}i64 @top(i64 %{{.*}})
+// CHECK: top(5) = 28
+
+/* main() and top() precede their callees in the binary. Their prototypes
+   are still constructed after those of middle() and leaf(), so the values
+   returned by the callees are used by the raised callers.
+ */
+
+#include <stdio.h>
+
+long __attribute__((noinline)) top(long n);
+long __attribute__((noinline)) middle(long n);
+long __attribute__((noinline)) leaf(long n);
+
+int main() {
+  printf("top(5) = %ld\n", top(5));
+  return 0;
+}
+
+long __attribute__((noinline)) top(long n) { return middle(n) * 2; }
+
+long __attribute__((noinline)) middle(long n) { return leaf(n) + 4; }
+
+long __attribute__((noinline)) leaf(long n) { return n * 2; }
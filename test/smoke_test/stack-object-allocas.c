@@ -0,0 +1,45 @@
+// REQUIRES: system-linux
+// RUN: clang -o %t %s -O0
+// RUN: llvm-mctoll -d -I /usr/include/stdio.h %t
+// RUN: FileCheck %s --check-prefix=IR < %t-dis.ll
+// RUN: clang -o %t1 %t-dis.ll
+// RUN: %t1 2>&1 | FileCheck %s
+// CHECK: Scalar locals 42
+// CHECK: Array locals 45
+
+// IR-LABEL: define {{.*}}@scalar_locals(
+// IR-NOT: %stktop_
+// IR: alloca i32
+// IR-NOT: %stktop_
+// IR-LABEL: define {{.*}}@array_locals(
+// IR: %stktop_{{[0-9]+}} = alloca i8, i32
+
+/* Locals of scalar_locals are only accessed in-bounds and are raised as
+   separate allocas. The array in array_locals is indexed dynamically and
+   requires the stack frame layout of the source binary to be preserved.
+ */
+
+#include <stdio.h>
+
+int __attribute__((noinline)) scalar_locals(int a, int b) {
+  int c = a * 2;
+  long d = b + c;
+  short e = (short)d;
+  return e + a;
+}
+
+int __attribute__((noinline)) array_locals(int n) {
+  int arr[10];
+  int sum = 0;
+  for (int i = 0; i < n; i++)
+    arr[i] = i;
+  for (int i = 0; i < n; i++)
+    sum += arr[i];
+  return sum;
+}
+
+int main() {
+  printf("Scalar locals %d\n", scalar_locals(10, 12));
+  printf("Array locals %d\n", array_locals(10));
+  return 0;
+}
@@ -0,0 +1,25 @@
+// REQUIRES: system-linux
+// RUN: clang -o %t %s -O2
+// RUN: llvm-mctoll -d -I /usr/include/stdio.h %t
+// RUN: FileCheck %s --check-prefix=IR < %t-dis.ll
+// RUN: clang -o %t1 %t-dis.ll
+// RUN: %t1 2>&1 | FileCheck %s
+// IR-DAG: define {{.*}}i64 @forward(i64 %{{.*}})
+// IR-DAG: = call i64 @forward(
+// CHECK: forward(1) + 1 = 6
+
+/* forward() only jumps to base(), so it defines no return value itself and
+   returns whatever base() returns. main() is raised before the return type
+   of forward() is applied, and uses the value it returns.
+ */
+
+#include <stdio.h>
+
+long __attribute__((noinline)) base(long n) { return n * 2 + 1; }
+
+long __attribute__((noinline)) forward(long n) { return base(n + 1); }
+
+int main(int argc, char **argv) {
+  printf("forward(%d) + 1 = %ld\n", argc, forward(argc) + 1);
+  return 0;
+}
@@ -0,0 +1,54 @@
+// REQUIRES: system-linux
+// RUN: clang -o %t %s -O2
+// RUN: llvm-mctoll -d -I /usr/include/stdio.h %t
+// RUN: FileCheck %s --check-prefix=IR < %t-dis.ll
+// RUN: FileCheck %s --check-prefix=ESCAPE < %t-dis.ll
+// RUN: clang -o %t1 %t-dis.ll
+// RUN: %t1 2>&1 | FileCheck %s
+// IR-DAG: musttail call {{.*}}@is_even(
+// IR-DAG: musttail call {{.*}}@is_odd(
+// ESCAPE-LABEL: define {{.*}}@sum_local(
+// ESCAPE-NOT: tail call
+// ESCAPE: = call {{.*}}@sum(
+// CHECK: is_even(100001) = 0
+// CHECK-NEXT: sum_local(1) = 10
+
+/* The jumps of is_odd() and is_even() to each other are raised as tail
+   calls, so the raised functions run in constant stack like the originals.
+   The call of sum() is in tail position but passes the address of a local
+   array of sum_local(), so it is not marked as a tail call.
+ */
+
+#include <stdio.h>
+
+long __attribute__((noinline)) is_even(long n);
+
+long __attribute__((noinline)) is_odd(long n) {
+  if (n == 0)
+    return 0;
+  return is_even(n - 1);
+}
+
+long __attribute__((noinline)) is_even(long n) {
+  if (n == 0)
+    return 1;
+  return is_odd(n - 1);
+}
+
+long __attribute__((noinline)) sum(long *p, long n) {
+  long s = 0;
+  for (long i = 0; i < n; i++)
+    s += p[i];
+  return s;
+}
+
+long __attribute__((noinline)) sum_local(long n) {
+  long a[4] = {n, n + 1, n + 2, n + 3};
+  return sum(a, 4);
+}
+
+int main(int argc, char **argv) {
+  printf("is_even(100001) = %ld\n", is_even(100001));
+  printf("sum_local(%d) = %ld\n", argc, sum_local(argc));
+  return 0;
+}
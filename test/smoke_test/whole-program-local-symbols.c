@@ -0,0 +1,26 @@
+// REQUIRES: system-linux
+// RUN: clang -o %T/libwhole-program-local-symbols-lib.so %S/Inputs/whole-program-local-symbols-lib.c -O2 -fPIC -shared
+// RUN: clang -o %t %s -O2 -L%T/ -lwhole-program-local-symbols-lib
+// RUN: llvm-mctoll -d -I /usr/include/stdio.h --whole-program -L %T/ %t
+// RUN: FileCheck %s --check-prefix=IR < %t-dis.ll
+// RUN: clang -o %t1 %t-dis.ll
+// RUN: %t1 2>&1 | FileCheck %s
+
+/* The executable and the shared library both define a static helper(). The
+   functions raised from them have internal linkage, so the raised modules
+   link without a conflict. */
+
+// IR-DAG: define internal {{.*}}@helper(
+// IR-DAG: define internal {{.*}}@helper.{{[0-9]+}}(
+// CHECK: Scaled value is 21
+
+#include <stdio.h>
+
+extern int scale(int a);
+
+static int __attribute__((noinline)) helper(int a) { return a + 1; }
+
+int main(int argc, char **argv) {
+  printf("Scaled value is %d\n", scale(helper(argc + 5)));
+  return 0;
+}
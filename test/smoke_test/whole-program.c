@@ -0,0 +1,23 @@
+// REQUIRES: system-linux
+// RUN: clang -o %T/libwhole-program-lib.so %S/Inputs/whole-program-lib.c -O2 -fPIC -shared
+// RUN: clang -o %t %s -O2 -L%T/ -lwhole-program-lib
+// RUN: llvm-mctoll -d -I /usr/include/stdio.h --whole-program -L %T/ %t
+// RUN: FileCheck %s --check-prefix=IR < %t-dis.ll
+// RUN: clang -o %t1 %t-dis.ll
+// RUN: %t1 2>&1 | FileCheck %s
+
+/* The call to scale() through the PLT is bound to the function raised from
+   the shared library, so the raised program runs without it. */
+
+// IR-DAG: call {{.*}}i32 @scale(i32
+// IR-DAG: define {{.*}}i32 @scale(i32
+// CHECK: Scaled value is 21
+
+#include <stdio.h>
+
+extern int scale(int a);
+
+int main() {
+  printf("Scaled value is %d\n", scale(7));
+  return 0;
+}